@@ -1,46 +1,104 @@
 window.triangles = 0;
 
+// The layout of an interleaved vertex, which must match voxel::Vertex: a
+// float3 position, float3 normal, float2 texture coordinate and float2 atlas
+// tile.
+const VERTEX_FLOATS = 10;
+const VERTEX_STRIDE = 4 * VERTEX_FLOATS;
+const POSITION_OFFSET = 0;
+const NORMAL_OFFSET = 12;
+const TEXTURE_COORD_OFFSET = 24;
+const TEXTURE_TILE_OFFSET = 32;
+
+// The layout of a packed chunk vertex, which must match voxel::PackedVertex:
+// four bytes of block corner and face followed by four bytes of atlas tile
+// and texture coordinate.
+const PACKED_VERTEX_STRIDE = 8;
+const PACKED_POSITION_OFFSET = 0;
+const PACKED_TEXTURE_OFFSET = 4;
+
+// GPU buffers are allocated with this much headroom, so that a mesh which
+// grows slightly is uploaded with bufferSubData into the existing storage.
+const BUFFER_GROWTH_FACTOR = 1.25;
+
+// Views of the WebAssembly memory. Views are only valid until the memory
+// grows, at which point the underlying ArrayBuffer is replaced, so the views
+// record the buffer they were created from and are rebuilt when it changes.
+class MemoryViews {
+
+    constructor() {
+        this.memory = null;
+        this.uint8 = null;
+        this.uint32 = null;
+    }
+
+    update() {
+        const memory = instance.exports.memory.buffer;
+        if (memory !== this.memory) {
+            this.memory = memory;
+            this.uint8 = new Uint8Array(memory);
+            this.uint32 = new Uint32Array(memory);
+        }
+    }
+
+    // Reads the staging_region_t at the given address (see
+    // wasm/include/voxel/staging.hpp), a plain pointer and length, and
+    // returns the bytes it describes. WebGL 1 only accepts a view for
+    // bufferSubData, so this is a subarray of the cached memory view; the
+    // bytes themselves are not copied.
+    region(pointer) {
+        this.update();
+        const data = this.uint32[pointer >>> 2];
+        const size = this.uint32[(pointer >>> 2) + 1];
+        return this.uint8.subarray(data, data + size);
+    }
+}
+
 class GraphicsBuffer {
 
     constructor(gl) {
         this.gl = gl;
         this.vertexBuffer = gl.createBuffer();
         this.indexBuffer = gl.createBuffer();
-        this.normalBuffer = gl.createBuffer();
+        this.vertexCapacity = 0;
+        this.indexCapacity = 0;
         this.texture = 0;
-        this.textureBuffer = gl.createBuffer();
+        this.packed = false;
+        this.origin = [0, 0, 0];
+    }
 
+    // Uploads the given bytes to the start of the given GL buffer. The buffer
+    // storage is only reallocated when it is too small; otherwise the data is
+    // written into the existing storage with bufferSubData. Returns the
+    // capacity of the buffer.
+    upload(target, gl_buffer, capacity, data) {
+        const gl = this.gl;
+        gl.bindBuffer(target, gl_buffer);
+        if (data.byteLength > capacity) {
+            capacity = Math.ceil(data.byteLength * BUFFER_GROWTH_FACTOR);
+            gl.bufferData(target, capacity, gl.STATIC_DRAW);
+        }
+        if (data.byteLength > 0) {
+            gl.bufferSubData(target, 0, data);
+        }
+        return capacity;
     }
 
-    updateVertexBuffer(vertex_data_view) {
-        this.gl.bindBuffer(this.gl.ARRAY_BUFFER, this.vertexBuffer);
-        this.gl.bufferData(this.gl.ARRAY_BUFFER, vertex_data_view, this.gl.STATIC_DRAW);
+    updateVertexBuffer(data) {
+        this.vertexCapacity = this.upload(this.gl.ARRAY_BUFFER, this.vertexBuffer, this.vertexCapacity, data);
     }
 
-    updateIndexBuffer(index_data_view) {
-        this.gl.bindBuffer(this.gl.ELEMENT_ARRAY_BUFFER, this.indexBuffer);
-        this.gl.bufferData(this.gl.ELEMENT_ARRAY_BUFFER, index_data_view, this.gl.STATIC_DRAW);    
+    updateIndexBuffer(data) {
+        this.indexCapacity = this.upload(this.gl.ELEMENT_ARRAY_BUFFER, this.indexBuffer, this.indexCapacity, data);
     }
 
     updateTexture(texture_index) {
         this.texture = texture_index;
     }
 
-    updateNormalBuffer(normal_data_view) {
-        this.gl.bindBuffer(this.gl.ARRAY_BUFFER, this.normalBuffer);
-        this.gl.bufferData(this.gl.ARRAY_BUFFER, normal_data_view, this.gl.STATIC_DRAW);
-    }
-
-    updateTextureBuffer(texture_data_view) {
-        this.gl.bindBuffer(this.gl.ARRAY_BUFFER, this.textureBuffer);
-        this.gl.bufferData(this.gl.ARRAY_BUFFER, texture_data_view, this.gl.STATIC_DRAW);
-    }
-
     release() {
         this.gl.deleteBuffer(this.vertexBuffer);
         this.gl.deleteBuffer(this.indexBuffer);
-        this.gl.deleteBuffer(this.normalBuffer);
-        this.gl.deleteBuffer(this.textureBuffer);
     }
 }
 
@@ -48,7 +106,15 @@ class Graphics {
 
     constructor(gl) {
         this.gl = gl;
+        // Chunk meshes may exceed 65536 vertices, so all index buffers are
+        // uploaded as 32 bit indices.
+        if (!gl.getExtension('OES_element_index_uint')) {
+            alert('Unable to initialize WebGL. Your browser does not support 32 bit index buffers.');
+        }
         this.program_info = getProgramInfo(gl)
+        this.chunk_program_info = getChunkProgramInfo(gl);
+        this.current_program_info = null;
+        this.memory_views = new MemoryViews();
         this.buffers = [];
         this.textures = [
             loadTexture(gl, './textures/blocks.png'),
@@ -60,35 +126,26 @@ class Graphics {
         return this.buffers.push(new GraphicsBuffer(this.gl)) - 1;
     }
 
-    updateVertexBuffer(index, vertices, n_vertices) {
-        const wasm_memory = instance.exports.memory.buffer;
-        const vertex_data_view = new Float32Array(wasm_memory, vertices, 3 * n_vertices);
-        this.buffers[index].updateVertexBuffer(vertex_data_view);
+    updateVertexBuffer(index, region, n_vertices) {
+        this.buffers[index].packed = false;
+        this.buffers[index].updateVertexBuffer(this.memory_views.region(region));
     }
 
-    updateIndexBuffer(index, faces, n_faces){
-        const wasm_memory = instance.exports.memory.buffer;
-        const index_data_view = new Uint16Array(wasm_memory, faces, 3 * n_faces);
+    updatePackedVertexBuffer(index, region, n_vertices, x, y, z) {
+        this.buffers[index].packed = true;
+        this.buffers[index].origin = [x, y, z];
+        this.buffers[index].updateVertexBuffer(this.memory_views.region(region));
+    }
+
+    updateIndexBuffer(index, region, n_faces){
         this.buffers[index].n_faces = n_faces;
-        this.buffers[index].updateIndexBuffer(index_data_view);
+        this.buffers[index].updateIndexBuffer(this.memory_views.region(region));
     }
 
     updateTexture(index, texture_index) {
         this.buffers[index].texture = texture_index;
     }
 
-    updateNormalBuffer(index, normals, n_normals) {
-        const wasm_memory = instance.exports.memory.buffer;
-        const normal_data_view = new Float32Array(wasm_memory, normals, 3 * n_normals);
-        this.buffers[index].updateNormalBuffer(normal_data_view);
-    }
-
-    updateTextureBuffer(index, texture_coords, n_texture_coords) {
-        const wasm_memory = instance.exports.memory.buffer;
-        const texture_data_view = new Float32Array(wasm_memory, texture_coords, 2 * n_texture_coords);
-        this.buffers[index].updateTextureBuffer(texture_data_view);
-    }
-
     deleteBuffer(index) {
         if (index != -1) {
             this.buffers[index].release();
@@ -102,30 +159,57 @@ class Graphics {
         const model_view_matrix_view =  new Float32Array(wasm_memory, model_view_matrix, 16);
         const projection_matrix_view =  new Float32Array(wasm_memory, projection_matrix, 16);
         
-        gl.bindBuffer(gl.ARRAY_BUFFER, this.buffers[index].vertexBuffer);
-        gl.vertexAttribPointer(this.program_info.attribLocations.vertexPosition, 3, gl.FLOAT, false, 0, 0);
-        gl.enableVertexAttribArray(this.program_info.attribLocations.vertexPosition);
-
-
-        gl.bindBuffer(gl.ARRAY_BUFFER, this.buffers[index].textureBuffer);
-        gl.vertexAttribPointer(this.program_info.attribLocations.textureCoord, 2, gl.FLOAT, false, 0, 0);
-        gl.enableVertexAttribArray(this.program_info.attribLocations.textureCoord);
-
-        gl.bindBuffer(gl.ARRAY_BUFFER, this.buffers[index].normalBuffer);
-        gl.vertexAttribPointer(this.program_info.attribLocations.vertexNormal, 3, gl.FLOAT,  false, 0, 0);
-        gl.enableVertexAttribArray(this.program_info.attribLocations.vertexNormal);
+        const buffer = this.buffers[index];
+        const program_info = buffer.packed ? this.chunk_program_info: this.program_info;
+        this.useProgram(program_info);
+
+        // All attributes are read from the single interleaved vertex buffer.
+        const attribLocations = program_info.attribLocations;
+        gl.bindBuffer(gl.ARRAY_BUFFER, buffer.vertexBuffer);
+        if (buffer.packed) {
+            gl.vertexAttribPointer(attribLocations.packedPosition, 4, gl.UNSIGNED_BYTE, false, PACKED_VERTEX_STRIDE, PACKED_POSITION_OFFSET);
+            gl.vertexAttribPointer(attribLocations.packedTexture, 4, gl.UNSIGNED_BYTE, false, PACKED_VERTEX_STRIDE, PACKED_TEXTURE_OFFSET);
+            gl.uniform3fv(program_info.uniformLocations.chunkOrigin, buffer.origin);
+        } else {
+            gl.vertexAttribPointer(attribLocations.vertexPosition, 3, gl.FLOAT, false, VERTEX_STRIDE, POSITION_OFFSET);
+            gl.vertexAttribPointer(attribLocations.vertexNormal, 3, gl.FLOAT, false, VERTEX_STRIDE, NORMAL_OFFSET);
+            gl.vertexAttribPointer(attribLocations.textureCoord, 2, gl.FLOAT, false, VERTEX_STRIDE, TEXTURE_COORD_OFFSET);
+            gl.vertexAttribPointer(attribLocations.textureTile, 2, gl.FLOAT, false, VERTEX_STRIDE, TEXTURE_TILE_OFFSET);
+        }
 
-        gl.bindBuffer(gl.ELEMENT_ARRAY_BUFFER, this.buffers[index].indexBuffer);
-        gl.useProgram(this.program_info.program);
-        gl.uniformMatrix4fv(this.program_info.uniformLocations.modelViewMatrix, false, model_view_matrix_view);
-        gl.uniformMatrix4fv(this.program_info.uniformLocations.projectionMatrix, false, projection_matrix_view);
+        gl.bindBuffer(gl.ELEMENT_ARRAY_BUFFER, buffer.indexBuffer);
+        gl.uniformMatrix4fv(program_info.uniformLocations.modelViewMatrix, false, model_view_matrix_view);
+        gl.uniformMatrix4fv(program_info.uniformLocations.projectionMatrix, false, projection_matrix_view);
 
         gl.activeTexture(gl.TEXTURE0);
-        gl.bindTexture(gl.TEXTURE_2D, this.textures[this.buffers[index].texture]);
-        gl.uniform1i(this.program_info.uniformLocations.uSampler, 0);
+        gl.bindTexture(gl.TEXTURE_2D, this.textures[buffer.texture]);
+        gl.uniform1i(program_info.uniformLocations.uSampler, 0);
+
+        gl.drawElements(gl.TRIANGLES, 3 * buffer.n_faces, gl.UNSIGNED_INT, 0)
+        window.triangles += buffer.n_faces;
+    }
 
-        gl.drawElements(gl.TRIANGLES, 3 * this.buffers[index].n_faces, gl.UNSIGNED_SHORT, 0)
-        window.triangles += this.buffers[index].n_faces;
+    // Switches to the given shader program, enabling exactly the vertex
+    // attribute arrays that it reads.
+    useProgram(program_info) {
+        if (this.current_program_info === program_info) {
+            return;
+        }
+        const gl = this.gl;
+        if (this.current_program_info) {
+            for (const location of Object.values(this.current_program_info.attribLocations)) {
+                if (location >= 0) {
+                    gl.disableVertexAttribArray(location);
+                }
+            }
+        }
+        gl.useProgram(program_info.program);
+        for (const location of Object.values(program_info.attribLocations)) {
+            if (location >= 0) {
+                gl.enableVertexAttribArray(location);
+            }
+        }
+        this.current_program_info = program_info;
     }
 }
 
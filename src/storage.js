@@ -0,0 +1,49 @@
+/*
+ * An in-memory stand-in for persistent browser storage.
+ * Files are stored as growable byte arrays keyed by name and are read and
+ * written at arbitrary offsets, which is all the region file format needs.
+ * A persistent backend such as IndexedDB can replace this class without
+ * changing the WASM interface.
+ */
+class RegionStorage {
+
+    constructor() {
+        this.files = new Map();
+    }
+
+    size(name) {
+        const file = this.files.get(name);
+        return file ? file.length : 0;
+    }
+
+    read(name, offset, length) {
+        const file = this.files.get(name);
+        if (!file || offset >= file.length) {
+            return new Uint8Array(0);
+        }
+        return file.subarray(offset, Math.min(offset + length, file.length));
+    }
+
+    write(name, offset, data) {
+        let file = this.files.get(name) || new Uint8Array(0);
+        const length = offset + data.length;
+        if (length > file.buffer.byteLength) {
+            // Out of capacity: reallocate, doubling so that appends are
+            // amortized constant time.
+            let capacity = Math.max(file.buffer.byteLength, 1024);
+            while (capacity < length) {
+                capacity *= 2;
+            }
+            const grown = new Uint8Array(new ArrayBuffer(capacity), 0, length);
+            grown.set(file);
+            file = grown;
+        } else if (length > file.length) {
+            // Extend the logical length within the existing capacity.
+            file = new Uint8Array(file.buffer, 0, length);
+        }
+        file.set(data, offset);
+        this.files.set(name, file);
+    }
+}
+
+export { RegionStorage };
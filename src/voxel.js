@@ -1,6 +1,7 @@
 import { KeyboardInput } from './keyboard.js'
 import { FPSTracker } from './fps.js'
 import { Graphics } from './gpu.js'
+import { RegionStorage } from './storage.js'
 
 const server_address = '10.8.29.204'
 const server_port = '3000'
@@ -19,6 +20,16 @@ gl.enable(gl.BLEND);
 
 const graphics = new Graphics(gl);
 
+/* Region file storage for evicted chunks */
+const storage = new RegionStorage();
+
+function read_string(pointer) {
+    let memory = instance.exports.memory.buffer;
+    let uint8_view = new Uint8Array(memory, pointer);
+    let length = uint8_view.indexOf(0);
+    return String.fromCharCode(...uint8_view.subarray(0, length));
+}
+
 /* FPS Tracker UI Element */
 const frameCounter = new FPSTracker('fps');
 
@@ -77,6 +88,9 @@ async function load_game_source() {
                 random: function() {
                     return Math.random();
                 },
+                now: function() {
+                    return performance.now();
+                },
                 update_health: function(health) {
                     document.getElementById('health').innerText = `Health: ${health}`
                 },
@@ -99,14 +113,23 @@ async function load_game_source() {
                         let src_view = new Uint8Array(result);
                         let pointer = instance.exports.malloc(length);
                         let array_buffer = instance.exports.memory.buffer;
-                        let dst_view = new Uint8Array(array_buffer, pointer, result.byteLength);
-                        for (let i = 0; i < result.byteLength; i++) {
-                            dst_view[i] = src_view[i];
-                        }
+                        new Uint8Array(array_buffer, pointer, length).set(src_view);
                         instance.exports.fetch_callback(self, pointer, length);
                         instance.exports.free(pointer);
                     });
                 },
+                storage_size: function(name) {
+                    return storage.size(read_string(name));
+                },
+                storage_read: function(name, buffer, offset, length) {
+                    const data = storage.read(read_string(name), offset, length);
+                    new Uint8Array(instance.exports.memory.buffer, buffer, data.length).set(data);
+                    return data.length;
+                },
+                storage_write: function(name, buffer, offset, length) {
+                    const data = new Uint8Array(instance.exports.memory.buffer, buffer, length);
+                    storage.write(read_string(name), offset, data);
+                },
                 game_over: function() {
                     window.location.replace("game_over");
 
@@ -145,9 +168,8 @@ async function load_game_source() {
 
                 create_buffer: graphics.createBuffer.bind(graphics),
                 update_vertex_buffer: graphics.updateVertexBuffer.bind(graphics),
-                update_normal_buffer: graphics.updateNormalBuffer.bind(graphics),
+                update_packed_vertex_buffer: graphics.updatePackedVertexBuffer.bind(graphics),
                 update_index_buffer: graphics.updateIndexBuffer.bind(graphics),
-                update_texture_buffer: graphics.updateTextureBuffer.bind(graphics),
                 update_texture: graphics.updateTexture.bind(graphics),
                 delete_buffer: graphics.deleteBuffer.bind(graphics),
                 draw_buffer: graphics.drawBuffer.bind(graphics)
@@ -182,10 +204,7 @@ function game_loop() {
             let src_view = new Uint8Array(result);
             let pointer = instance.exports.malloc(result.byteLength);
             let array_buffer = instance.exports.memory.buffer;
-            let dst_view = new Uint8Array(array_buffer, pointer, result.byteLength);
-            for (let i = 0; i < result.byteLength; i++) {
-                dst_view[i] = src_view[i];
-            }
+            new Uint8Array(array_buffer, pointer, result.byteLength).set(src_view);
             instance.exports.world_message_handler(world, pointer);
             instance.exports.free(pointer);
         });
@@ -200,7 +219,9 @@ function game_loop() {
         const deltaTime = now - then;
         then = now;
         window.triangles = 0;
-        update(world, deltaTime > 0.1? 0.1: deltaTime);
+        // The simulation runs in fixed steps, and caps the steps taken per
+        // frame itself, so the full frame time is passed through.
+        update(world, deltaTime);
         gl.clearColor(0.554, 0.746, 0.988, 1.0); 
         gl.clearDepth(1.0); 
         gl.enable(gl.DEPTH_TEST);
@@ -216,14 +237,7 @@ function game_loop() {
 }
 
 function update(world, dt) {
-    instance.exports.world_update(
-        world, dt,
-        keyboard.active('forwards'),
-        keyboard.active('backwards'),
-        keyboard.active('left'),
-        keyboard.active('right'),
-        keyboard.active('up')
-    );
+    instance.exports.world_advance(world, dt);
 }
 
 
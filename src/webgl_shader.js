@@ -25,22 +25,51 @@ function initShaderProgram(gl, vsSource, fsSource) {
   }
 
 
+// Fragment shader shared by the mesh and chunk programs.
+const textureFragmentShaderSource = `
+    varying highp vec2 vTextureCoord;
+    varying highp vec2 vTextureTile;
+    varying highp vec3 vLighting;
+    varying highp float vDistance;
+
+    uniform sampler2D uSampler;
+
+    void main(void) {
+      // Merged quads repeat their atlas tile once per block. Coordinates in
+      // (k, k + 1] map to (0, 1] rather than using fract, so a coordinate of
+      // exactly 1.0 on the edge of a single block quad stays on the far
+      // edge of its tile instead of wrapping to the near edge, while
+      // coordinates in [0, 1] are used unchanged.
+      highp vec2 textureCoord = vTextureCoord;
+      if (vTextureTile.x >= 0.0) {
+        highp vec2 local = vTextureCoord - max(ceil(vTextureCoord) - 1.0, 0.0);
+        textureCoord = (vTextureTile + local) / 16.0;
+      }
+      highp vec4 texelColor = texture2D(uSampler, textureCoord);
+      gl_FragColor = vec4(texelColor.rgb * vLighting, texelColor.a);
+      gl_FragColor = (1.0 / vDistance)* gl_FragColor + (1.0 - 1.0 / vDistance) * vec4(0.554, 0.746, 0.988, 1.0);
+    }
+`;
+
 function getProgramInfo(gl) {
   const vsSource = `
     attribute vec4 aVertexPosition;
     attribute vec3 aVertexNormal;
     attribute vec2 aTextureCoord;
+    attribute vec2 aTextureTile;
 
     uniform mat4 uModelViewMatrix;
     uniform mat4 uProjectionMatrix;
 
     varying highp vec2 vTextureCoord;
+    varying highp vec2 vTextureTile;
     varying highp vec3 vLighting;
     varying highp float vDistance;
 
     void main(void) {
       gl_Position = uProjectionMatrix  * uModelViewMatrix * aVertexPosition;
       vTextureCoord = aTextureCoord;
+      vTextureTile = aTextureTile;
 
       // Apply lighting effect
       highp vec3 activeLight = vec3(0.3, 0.3, 1.0);
@@ -56,21 +85,7 @@ function getProgramInfo(gl) {
     }
   `;
 
-  // Fragment shader program
-
-  const fsSource = `
-    varying highp vec2 vTextureCoord;
-    varying highp vec3 vLighting;
-    varying highp float vDistance;
-
-    uniform sampler2D uSampler;
-
-    void main(void) {
-      highp vec4 texelColor = texture2D(uSampler, vTextureCoord);
-      gl_FragColor = vec4(texelColor.rgb * vLighting, texelColor.a);
-      gl_FragColor = (1.0 / vDistance)* gl_FragColor + (1.0 - 1.0 / vDistance) * vec4(0.554, 0.746, 0.988, 1.0);
-    }
-  `;
+  const fsSource = textureFragmentShaderSource;
 
   // Initialize a shader program; this is where all the lighting
   // for the vertices and so forth is established.
@@ -86,9 +101,74 @@ function getProgramInfo(gl) {
       vertexPosition: gl.getAttribLocation(shaderProgram, 'aVertexPosition'),
       vertexNormal: gl.getAttribLocation(shaderProgram, 'aVertexNormal'),
       textureCoord: gl.getAttribLocation(shaderProgram, 'aTextureCoord'),
+      textureTile: gl.getAttribLocation(shaderProgram, 'aTextureTile'),
+
+    },
+    uniformLocations: {
+      modelViewMatrix: gl.getUniformLocation(shaderProgram, 'uModelViewMatrix'),
+      projectionMatrix: gl.getUniformLocation(shaderProgram, 'uProjectionMatrix'),
+      uSampler: gl.getUniformLocation(shaderProgram, 'uSampler'),
+    },
+  };
+}
+
+// Shader program for chunk meshes, whose vertices are packed into 8 bytes
+// (see voxel::PackedVertex): a block corner relative to uChunkOrigin and a
+// face index, followed by an atlas tile and tile-local texture coordinates.
+function getChunkProgramInfo(gl) {
+  const vsSource = `
+    attribute vec4 aPackedPosition;
+    attribute vec4 aPackedTexture;
+
+    uniform vec3 uChunkOrigin;
+    uniform mat4 uModelViewMatrix;
+    uniform mat4 uProjectionMatrix;
+
+    varying highp vec2 vTextureCoord;
+    varying highp vec2 vTextureTile;
+    varying highp vec3 vLighting;
+    varying highp float vDistance;
+
+    // The normals of the faces in the order of the Face enum: front, back,
+    // top, bottom, right and left.
+    vec3 faceNormal(float face) {
+      if (face < 0.5) return vec3(0.0, 0.0, 1.0);
+      if (face < 1.5) return vec3(0.0, 0.0, -1.0);
+      if (face < 2.5) return vec3(0.0, 1.0, 0.0);
+      if (face < 3.5) return vec3(0.0, -1.0, 0.0);
+      if (face < 4.5) return vec3(1.0, 0.0, 0.0);
+      return vec3(-1.0, 0.0, 0.0);
+    }
+
+    void main(void) {
+      // Blocks are two units wide and centered on even coordinates.
+      vec4 position = vec4(2.0 * (uChunkOrigin + aPackedPosition.xyz) - 1.0, 1.0);
+      gl_Position = uProjectionMatrix  * uModelViewMatrix * position;
+      vTextureTile = aPackedTexture.xy;
+      vTextureCoord = aPackedTexture.zw;
 
+      // Apply lighting effect
+      highp vec3 ambientLight = vec3(0.3, 0.3, 0.3);
+      highp vec3 directionalLightColor = vec3(1, 1, 1);
+      highp vec3 directionalVector = normalize(vec3(0.85, 0.8, 0.75));
+
+      highp vec4 transformedNormal = normalize(uModelViewMatrix * vec4(faceNormal(aPackedPosition.w), 0.0));
+
+      highp float directional = max(dot(transformedNormal.xyz, directionalVector), 0.0);
+      vLighting = ambientLight + (directionalLightColor * directional);
+      vDistance = 1.0 + 0.001 * exp(distance(gl_Position.xyz, vec3(0.0,0.0,0.0))/4.0);
+    }
+  `;
+
+  const shaderProgram = initShaderProgram(gl, vsSource, textureFragmentShaderSource);
+  return {
+    program: shaderProgram,
+    attribLocations: {
+      packedPosition: gl.getAttribLocation(shaderProgram, 'aPackedPosition'),
+      packedTexture: gl.getAttribLocation(shaderProgram, 'aPackedTexture'),
     },
     uniformLocations: {
+      chunkOrigin: gl.getUniformLocation(shaderProgram, 'uChunkOrigin'),
       modelViewMatrix: gl.getUniformLocation(shaderProgram, 'uModelViewMatrix'),
       projectionMatrix: gl.getUniformLocation(shaderProgram, 'uProjectionMatrix'),
       uSampler: gl.getUniformLocation(shaderProgram, 'uSampler'),
@@ -12,4 +12,32 @@ extern "C" void free (void *ptr);
 extern "C" void *realloc(void *ptr, size_t size);
 extern "C" void *calloc (size_t nmemb, size_t size);
 
+/**
+ * Placement new, which constructs an object in already allocated memory.
+ */
+inline void* operator new(size_t, void *p) noexcept {
+    return p;
+}
+
+/**
+ * Counters describing how the allocator has satisfied realloc requests.
+ * A realloc which grows a block in place both absorbs the following free
+ * block and extends the heap if the block sits at the top of the heap, in
+ * which case both counters are incremented.
+ */
+struct mem_stats_t {
+    uint32_t realloc_count;         // calls to realloc with a non-null pointer
+    uint32_t realloc_fit_count;     // the existing block was already large enough
+    uint32_t realloc_absorb_count;  // the following free block was absorbed
+    uint32_t realloc_extend_count;  // the block was extended at the heap break
+    uint32_t realloc_move_count;    // the block had to be moved and copied
+    uint32_t realloc_bytes_copied;  // bytes copied by moved reallocations
+};
+
+/**
+ * Returns the allocator statistics. The counters are laid out as
+ * consecutive uint32_t values so they can be read from javascript.
+ */
+extern "C" mem_stats_t* mem_stats(void);
+
 #endif
\ No newline at end of file
@@ -9,6 +9,14 @@ extern uint8_t __heap_base;
 extern "C" int memcpy(void *a, void *b, size_t n);
 extern "C" int memset(void *a, char b, size_t n);
 
+/**
+ * Compares a byte-by-byte copy with memcpy by copying a buffer the size of
+ * a dense chunk mesh `iterations` times, and prints the time taken in
+ * milliseconds by the byte loop, by memcpy, and by memcpy from a misaligned
+ * source. This is intended to be called from the browser console.
+ */
+extern "C" void memory_benchmark(int iterations);
+
 #define TRUE 1
 #define FALSE 0
 #define NULL 0
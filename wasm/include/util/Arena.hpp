@@ -0,0 +1,162 @@
+#ifndef VOXEL_ARENA_HPP
+#define VOXEL_ARENA_HPP
+
+/**
+ * \file Arena.hpp
+ * \brief A bump allocator for short-lived scratch memory.
+ * \author Thomas Barrett <tbarrett@caltech.edu>
+ * \date Dec 12, 2019
+ */
+
+#include <libc/stdlib.hpp>
+
+namespace voxel {
+
+/**
+ * A bump allocator for scratch memory which is released all at once.
+ *
+ * Memory is handed out sequentially from a region obtained from the heap.
+ * Individual allocations are never freed. Instead, `reset` releases every
+ * allocation made since the previous reset in O(1). When a region is full a
+ * larger one is allocated, and on reset every region but the largest is
+ * returned to the heap. After a few resets the arena therefore settles on a
+ * single region large enough for its workload, and subsequent use no longer
+ * touches the heap at all.
+ *
+ * The constructor does not allocate, so an Arena may be a global variable.
+ */
+class Arena {
+private:
+    const static size_t ALIGNMENT = 4;
+    const static size_t DEFAULT_REGION_SIZE = 1 << 16;
+
+    struct Region {
+        Region *next;
+        size_t capacity;
+        size_t used;
+    };
+
+    Region *region_ = nullptr;
+    void *last_ = nullptr;
+
+    static size_t align(size_t size) {
+        return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    }
+
+    static uint8_t* data(Region *region) {
+        return (uint8_t *) (region + 1);
+    }
+
+    /**
+     * Allocates a new region with room for at least `size` bytes and makes
+     * it the current region. The previous region is kept until the next
+     * reset, since it may still hold live allocations.
+     */
+    void grow(size_t size) {
+        size_t capacity = region_ ? 2 * region_->capacity: DEFAULT_REGION_SIZE;
+        while (capacity < size) {
+            capacity *= 2;
+        }
+        Region *region = (Region *) malloc(sizeof(Region) + capacity);
+        region->next = region_;
+        region->capacity = capacity;
+        region->used = 0;
+        region_ = region;
+    }
+
+public:
+    constexpr Arena() {}
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    /**
+     * Returns `size` bytes of uninitialized memory which remains valid until
+     * the next call to `reset`.
+     */
+    void* allocate(size_t size) {
+        size = align(size);
+        if (region_ == nullptr || region_->used + size > region_->capacity) {
+            grow(size);
+        }
+        void *p = data(region_) + region_->used;
+        region_->used += size;
+        last_ = p;
+        return p;
+    }
+
+    /**
+     * Resizes an allocation of `old_size` bytes to `size` bytes. The most
+     * recent allocation is resized in place if the current region has room,
+     * which is the common case for a single growing buffer. Otherwise the
+     * contents are copied to a new allocation.
+     */
+    void* reallocate(void *p, size_t old_size, size_t size) {
+        if (p != nullptr && p == last_) {
+            size_t offset = (uint8_t *) p - data(region_);
+            if (offset + align(size) <= region_->capacity) {
+                region_->used = offset + align(size);
+                return p;
+            }
+        }
+        if (size <= old_size) {
+            return p;
+        }
+        void *n = allocate(size);
+        if (p != nullptr) {
+            memcpy(n, p, old_size);
+        }
+        return n;
+    }
+
+    /**
+     * Releases every allocation made since the previous reset. Every region
+     * except the current, largest, one is returned to the heap.
+     */
+    void reset() {
+        if (region_ == nullptr) {
+            return;
+        }
+        Region *region = region_->next;
+        while (region != nullptr) {
+            Region *next = region->next;
+            free(region);
+            region = next;
+        }
+        region_->next = nullptr;
+        region_->used = 0;
+        last_ = nullptr;
+    }
+
+    /**
+     * Returns the number of bytes currently allocated from the arena.
+     */
+    size_t used() {
+        size_t used = 0;
+        for (Region *region = region_; region != nullptr; region = region->next) {
+            used += region->used;
+        }
+        return used;
+    }
+};
+
+/**
+ * An ArrayList allocator which allocates from the given Arena. Memory is
+ * only reclaimed when the arena is reset, so a list using this allocator
+ * must not outlive the next reset of its arena.
+ */
+template <Arena &arena> struct ArenaAllocator {
+    static void* allocate(size_t size) {
+        return arena.allocate(size);
+    }
+
+    static void* reallocate(void *p, size_t old_size, size_t size) {
+        return arena.reallocate(p, old_size, size);
+    }
+
+    static void deallocate(void *) {}
+};
+
+};
+
+#endif /* VOXEL_ARENA_HPP */
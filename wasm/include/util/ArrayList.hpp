@@ -13,80 +13,126 @@
 
 namespace voxel {
 
+/**
+ * The default ArrayList allocator, which allocates from the heap.
+ * An allocator provides static allocate, reallocate and deallocate functions;
+ * reallocate receives the previous size of the allocation so that allocators
+ * which do not track allocation sizes can copy its contents.
+ */
+struct HeapAllocator {
+    static void* allocate(size_t size) {
+        return malloc(size);
+    }
+
+    static void* reallocate(void *p, size_t old_size, size_t size) {
+        return realloc(p, size);
+    }
+
+    static void deallocate(void *p) {
+        free(p);
+    }
+};
+
 /**
  * A generic array-list implementation.
+ * The buffer is obtained from `Allocator`, which defaults to the heap. The
+ * buffer is allocated lazily on the first insertion and grows by doubling.
+ * Elements are relocated by the allocator with a bitwise copy when the
+ * buffer grows, so T must not hold pointers into itself.
+ *
+ * ArrayLists are move-only. A moved-from list is empty and may be reused.
  */
-template <typename T> class ArrayList {
+template <typename T, typename Allocator = HeapAllocator> class ArrayList {
 private:
     const static unsigned int DEFAULT_CAPACITY = 16;
     unsigned int size_ = 0;
     unsigned int capacity_ = 0;
-    T *buffer_ = 0;
+    T *buffer_ = nullptr;
 
-public:
+    /**
+     * Destroys every element and releases the buffer, leaving the list empty
+     * with no capacity.
+     */
+    void release() {
+        clear();
+        if (buffer_ != nullptr) {
+            Allocator::deallocate(buffer_);
+        }
+        buffer_ = nullptr;
+        capacity_ = 0;
+    }
 
     /**
-     * Constructs an ArrayList with an initial capacity of the default size.
+     * Ensures that there is room for at least one more element, doubling the
+     * capacity of the buffer if it is full.
      */
-    ArrayList() {
-        capacity_ = DEFAULT_CAPACITY;
-        size_ = 0;
-        buffer_ = (T*) malloc(sizeof(T) * capacity_);;
+    void grow() {
+        if (size_ == capacity_) {
+            reserve(capacity_ == 0 ? DEFAULT_CAPACITY: 2 * capacity_);
+        }
     }
 
+public:
+
+    /**
+     * Constructs an empty ArrayList. No memory is allocated until the first
+     * element is inserted.
+     */
+    ArrayList() = default;
+
     /**
      * Move constructor.
-     * Performs a shallow copy of all fields and sets the buffer_ field of the
-     * original object to nullptr to prevent it from being freed. The initial
-     * ArrayList is unusable after this constructor is called.
+     * Takes ownership of the buffer of the original ArrayList, which is left
+     * empty.
      */
     ArrayList(ArrayList &&list) {
-        capacity_ = list.capacity_;
         size_ = list.size_;
+        capacity_ = list.capacity_;
         buffer_ = list.buffer_;
+        list.size_ = 0;
+        list.capacity_ = 0;
         list.buffer_ = nullptr;
     }
 
     /**
-     * Copy constructor.
-     * Copies all fields. A new buffer_ field is allocated with the same
-     * capacity of the original ArrayList. All elements from the original
-     * ArrayList are copied into the buffer.
+     * Move assignment operator.
+     * Destroys the contents of this ArrayList and takes ownership of the
+     * buffer of the original ArrayList, which is left empty.
      */
-    ArrayList(const ArrayList &list) {
-        capacity_ = list.capacity_;
-        size_ = list.size_;
-        buffer_ = (T*) malloc(sizeof(T) * capacity_);
-        for (int i = 0; i < size_; i++) {
-            buffer_[i] = list.buffer_[i];
+    ArrayList &operator=(ArrayList &&list) {
+        if (this != &list) {
+            release();
+            size_ = list.size_;
+            capacity_ = list.capacity_;
+            buffer_ = list.buffer_;
+            list.size_ = 0;
+            list.capacity_ = 0;
+            list.buffer_ = nullptr;
         }
+        return *this;
     }
 
-    /**
-     * Assignment Operator.
-     * Default assignment operator calls custom copy constructor.
-     */
-    ArrayList &operator=(const ArrayList &) = default;	
+    ArrayList(const ArrayList &) = delete;
+    ArrayList &operator=(const ArrayList &) = delete;
 
     /**
      * Removes all elements from the ArrayList.
-     * This operation is implemented by simply setting the 'size_' field to
-     * zero indicating that all old value can be overwritten. Before this is
-     * done, the destructor for each element is called.
+     * The destructor of each element is called and the 'size_' field is set
+     * to zero. The capacity of the buffer is retained.
      */
     void clear() {
-        for (int i = 0; i < size_; i++) {
+        for (unsigned int i = 0; i < size_; i++) {
             buffer_[i].~T();
         }
         size_ = 0;
     }
 
     T* begin() {
-        return &buffer_[0];
+        return buffer_;
     }
 
     T* end() {
-        return &buffer_[size_];
+        return buffer_ + size_;
     }
 
     T& operator[](int i) {
@@ -97,37 +143,99 @@ public:
         return size_;
     }
 
+    unsigned int capacity() {
+        return capacity_;
+    }
+
     T* buffer() {
         return buffer_;
     }
 
     /**
-     * Appends an element to the list.
-     * If there is enoughg capacity to insert the element, then the element
+     * Ensures that the buffer can hold at least `capacity` elements without
+     * being reallocated.
+     */
+    void reserve(unsigned int capacity) {
+        if (capacity > capacity_) {
+            buffer_ = (T *) Allocator::reallocate((void*) buffer_, sizeof(T) * capacity_, sizeof(T) * capacity);
+            capacity_ = capacity;
+        }
+    }
+
+    /**
+     * Reduces the capacity of the buffer to the number of elements in the
+     * list. The buffer is released entirely if the list is empty.
+     */
+    void shrink_to_fit() {
+        if (size_ == 0) {
+            release();
+        } else if (size_ < capacity_) {
+            buffer_ = (T *) Allocator::reallocate((void*) buffer_, sizeof(T) * capacity_, sizeof(T) * size_);
+            capacity_ = size_;
+        }
+    }
+
+    /**
+     * Appends a copy of an element to the list.
+     * If there is enough capacity to insert the element, then the element
      * is inserted at the end of the buffer and the `size_` field is
      * incremented. Otherwise, the `buffer_` is reallocated with double the
-     * capacity. 
+     * capacity.
      */
     void append(const T &e) {
-        if (size_ == capacity_) {
-            capacity_ *= 2;
-            buffer_ = (T *) realloc((void*) buffer_, sizeof(T) * capacity_);
-        }
-        
-        buffer_[size_] = (T &&) e;
+        grow();
+        new (&buffer_[size_]) T(e);
+        size_ += 1;
+    }
+
+    /**
+     * Appends an element to the list by moving it.
+     */
+    void append(T &&e) {
+        grow();
+        new (&buffer_[size_]) T((T &&) e);
         size_ += 1;
     }
 
+    /**
+     * Constructs an element in place at the end of the list from the given
+     * constructor arguments.
+     * \returns a reference to the new element.
+     */
+    template <typename... Args> T& emplace_back(Args&&... args) {
+        grow();
+        T *e = new (&buffer_[size_]) T((Args &&) args...);
+        size_ += 1;
+        return *e;
+    }
+
+    /**
+     * Removes the last element of the list.
+     */
+    void pop_back() {
+        size_ -= 1;
+        buffer_[size_].~T();
+    }
+
+    /**
+     * Removes the element at index i by moving the last element of the list
+     * into its place. This is O(1) but does not preserve the order of the
+     * list.
+     */
+    void remove(int i) {
+        if (i != (int) size_ - 1) {
+            buffer_[i] = (T &&) buffer_[size_ - 1];
+        }
+        pop_back();
+    }
+
     /**
      * Deconstructor.
      * Calls the deconstructors of all elements in the buffer_ and frees the
      * buffer memory.
      */
     ~ArrayList() {
-        for (int i = 0; i < size_; i++) {
-            buffer_[i].~T();
-        }
-        free(buffer_);
+        release();
     }
 };
 
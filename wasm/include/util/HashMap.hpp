@@ -0,0 +1,173 @@
+#ifndef VOXEL_HASH_MAP_HPP
+#define VOXEL_HASH_MAP_HPP
+
+/**
+ * \file HashMap.hpp
+ * \brief An open-addressing hash map keyed by a two dimensional coordinate.
+ * \author Thomas Barrett <tbarrett@caltech.edu>
+ * \date Dec 12, 2019
+ */
+
+#include <libc/stdint.hpp>
+#include <util/ArrayList.hpp>
+
+namespace voxel {
+
+/**
+ * An open-addressing hash map keyed by an integer (x, z) coordinate pair.
+ *
+ * Collisions are resolved with linear probing. Erasing an entry uses
+ * backward-shift deletion rather than tombstones, so probe sequences never
+ * grow longer as entries are removed. The slot table is a power of two in
+ * size and is doubled whenever the load factor exceeds 1/2, which keeps the
+ * expected probe length constant.
+ */
+template <typename T> class HashMap {
+private:
+    struct Entry {
+        int x;
+        int z;
+        T value;
+        bool used;
+    };
+
+    const static unsigned int DEFAULT_CAPACITY = 64;
+    ArrayList<Entry> slots_;
+    unsigned int capacity_ = 0;
+    unsigned int size_ = 0;
+
+    /**
+     * Hashes the given coordinate pair. Neighbouring chunk coordinates differ
+     * in only their lowest bits, so both components are multiplied by large
+     * odd constants and the high bits are folded back down before masking.
+     */
+    static uint32_t hash(int x, int z) {
+        uint32_t h = (uint32_t) x * 0x9E3779B1u ^ (uint32_t) z * 0x85EBCA77u;
+        h ^= h >> 16;
+        return h;
+    }
+
+    unsigned int slot(int x, int z) const {
+        return hash(x, z) & (capacity_ - 1);
+    }
+
+    /**
+     * Resets the slot table to `capacity` empty entries.
+     */
+    void reset(unsigned int capacity) {
+        slots_.clear();
+        slots_.reserve(capacity);
+        for (unsigned int i = 0; i < capacity; i++) {
+            slots_.append({0, 0, T{}, false});
+        }
+        capacity_ = capacity;
+        size_ = 0;
+    }
+
+    /**
+     * Doubles the capacity of the slot table and reinserts every entry.
+     */
+    void grow() {
+        ArrayList<Entry> old{(ArrayList<Entry> &&) slots_};
+        unsigned int old_capacity = capacity_;
+        reset(2 * capacity_);
+        for (unsigned int i = 0; i < old_capacity; i++) {
+            if (old[i].used) {
+                insert(old[i].x, old[i].z, old[i].value);
+            }
+        }
+    }
+
+public:
+
+    /**
+     * Constructs an empty HashMap with the default capacity.
+     */
+    HashMap() {
+        reset(DEFAULT_CAPACITY);
+    }
+
+    HashMap(const HashMap &) = delete;
+    HashMap &operator=(const HashMap &) = delete;
+
+    unsigned int size() {
+        return size_;
+    }
+
+    /**
+     * Returns a pointer to the value stored at the given coordinate or
+     * nullptr if no such value exists.
+     */
+    T* lookup(int x, int z) {
+        unsigned int i = slot(x, z);
+        while (slots_[i].used) {
+            if (slots_[i].x == x && slots_[i].z == z) {
+                return &slots_[i].value;
+            }
+            i = (i + 1) & (capacity_ - 1);
+        }
+        return nullptr;
+    }
+
+    /**
+     * Inserts the value at the given coordinate, replacing any value which
+     * was previously stored there.
+     */
+    void insert(int x, int z, const T &value) {
+        if (2 * (size_ + 1) > capacity_) {
+            grow();
+        }
+        unsigned int i = slot(x, z);
+        while (slots_[i].used) {
+            if (slots_[i].x == x && slots_[i].z == z) {
+                slots_[i].value = value;
+                return;
+            }
+            i = (i + 1) & (capacity_ - 1);
+        }
+        slots_[i] = {x, z, value, true};
+        size_ += 1;
+    }
+
+    /**
+     * Removes the value stored at the given coordinate.
+     * Every entry in the probe run following the removed slot is shifted
+     * backwards if doing so moves it closer to its home slot.
+     * \returns true if a value was removed and false otherwise.
+     */
+    bool erase(int x, int z) {
+        unsigned int mask = capacity_ - 1;
+        unsigned int i = slot(x, z);
+        while (slots_[i].used) {
+            if (slots_[i].x == x && slots_[i].z == z) {
+                break;
+            }
+            i = (i + 1) & mask;
+        }
+        if (!slots_[i].used) {
+            return false;
+        }
+
+        unsigned int j = i;
+        while (true) {
+            j = (j + 1) & mask;
+            if (!slots_[j].used) {
+                break;
+            }
+            unsigned int home = slot(slots_[j].x, slots_[j].z);
+            // Entry j may fill the hole at i only if its home slot does not
+            // lie cyclically within (i, j].
+            if (((j - home) & mask) >= ((j - i) & mask)) {
+                slots_[i] = slots_[j];
+                i = j;
+            }
+        }
+        slots_[i].used = false;
+        size_ -= 1;
+        return true;
+    }
+};
+
+};
+
+#endif /* VOXEL_HASH_MAP_HPP */
@@ -36,15 +36,19 @@ public:
         physics_object.velocity.y = 0;
         physics_object.velocity.z = 0;
 
+        physics_object.previous_position = physics_object.position;
+
         
     
     }
 
-    void draw(mat4_t *projection_matrix) {
+    void draw(mat4_t *projection_matrix, float alpha) {
+        vec3_t position;
+        dyn_aabb3_interpolate(&physics_object, alpha, &position);
         voxel::Matrix model_view_matrix = (voxel::Matrix::Scale({0.3, 0.3, 0.3}) * voxel::Matrix::Translate({
-            physics_object.position.x,
-            physics_object.position.y,
-            physics_object.position.z
+            position.x,
+            position.y,
+            position.z
         })).tranpose(); 
 
         mesh->draw((mat4_t*) &model_view_matrix, projection_matrix);
@@ -6,79 +6,218 @@
 #include <util/Array.hpp>
 #include <util/Fetch.hpp>
 #include <voxel/graphics.hpp>
+#include <voxel/staging.hpp>
 #include <voxel/Browser.hpp>
 
 namespace voxel {
 
 /**
- * Represents a three dimensional mesh.
+ * An interleaved mesh vertex. All of the attributes of a vertex are stored
+ * contiguously, so that a mesh is uploaded as a single vertex buffer and the
+ * GPU fetches each vertex from a single cache line. The layout must match the
+ * attribute setup in `drawBuffer` in src/gpu.js.
+ *
+ * Vertices with an atlas tile treat their texture coordinates as repeating
+ * tile-local coordinates, which allows a single quad to span several blocks.
+ * Vertices without a tile, marked by a negative tile, use their texture
+ * coordinates as-is.
  */
-class Mesh {
+struct Vertex {
+    Array<float, 3> position;
+    Array<float, 3> normal;
+    Array<float, 2> texture_coord;
+    Array<float, 2> texture_tile = {-1, -1};
+};
+
+/**
+ * A compact vertex for block meshes, packed into 8 bytes.
+ *
+ * Positions are block corner coordinates relative to the origin of the mesh,
+ * which is passed to the shader as a uniform, so every coordinate of a chunk
+ * section fits in a byte. The normal is implied by the face, which is the
+ * index of the face's bit in the Face enum. Texture coordinates are repeating
+ * tile-local coordinates within the given atlas tile. The layout must match
+ * the attribute setup in `drawBuffer` in src/gpu.js.
+ */
+struct PackedVertex {
+    uint8_t x;
+    uint8_t y;
+    uint8_t z;
+    uint8_t face;
+    uint8_t tile_u;
+    uint8_t tile_v;
+    uint8_t u;
+    uint8_t v;
+};
+
+/**
+ * The vertices and faces of a mesh, stored in ArrayLists which allocate from
+ * `Allocator`. Faces are stored with 32 bit indices so that a single mesh may
+ * contain more than 65536 vertices, as is the case for dense chunks.
+ */
+template <typename Allocator = HeapAllocator, typename V = Vertex> class MeshData {
+public:
+    int modified = true;
+    ArrayList<V, Allocator> vertices;
+    ArrayList<Array<unsigned int, 3>, Allocator> faces;
+
+    void clear() {
+        vertices.clear();
+        faces.clear();
+    }
+
+    /**
+     * Preallocates room for the given number of vertices and faces.
+     */
+    void reserve(unsigned int vertex_count, unsigned int face_count) {
+        vertices.reserve(vertex_count);
+        faces.reserve(face_count);
+    }
+
+    void appendVertex(const V &v) {
+        vertices.append(v);
+        modified = true;
+    }
+
+    void appendFace(const Array<unsigned int, 3> &f) {
+        faces.append(f);
+        modified = true;
+    }
+
+    /**
+     * Returns the number of bytes of vertex and index data in the mesh.
+     */
+    unsigned int byteCount() {
+        return vertices.size() * sizeof(V)
+            + faces.size() * sizeof(Array<unsigned int, 3>);
+    }
+};
+
+/**
+ * Represents a three dimensional mesh and its GPU buffer.
+ * A mesh may be built in place and uploaded with `update()`, or built in a
+ * separate MeshData, such as one allocated from a scratch arena, and
+ * uploaded with `update(data)`, in which case the mesh keeps no copy of the
+ * data once it has been uploaded. Either way the data is uploaded directly
+ * from the memory in which it was built.
+ */
+class Mesh: public MeshData<> {
 public:
     int buffer;
-    int modified;
-    ArrayList<Array<float, 3>> vertices;
-    ArrayList<Array<float, 3>> normals;
-    ArrayList<Array<float, 2>> texture_coords;
-    ArrayList<Array<unsigned short, 3>> faces;
+private:
+    unsigned int vertex_count_ = 0;
+    unsigned int face_count_ = 0;
+    unsigned int byte_count_ = 0;
+
+    /**
+     * Stages the vertices of the given mesh data for upload. The vertices are
+     * uploaded in place, without being copied.
+     */
+    template <typename Allocator, typename V> void stageVertices(MeshData<Allocator, V> &data) {
+        staging_map(&vertex_staging_region, data.vertices.buffer(), sizeof(V) * data.vertices.size());
+    }
+
+    template <typename Allocator, typename V> void updateFaces(MeshData<Allocator, V> &data) {
+        staging_map(&index_staging_region, data.faces.buffer(), sizeof(data.faces[0]) * data.faces.size());
+        update_index_buffer(buffer, &index_staging_region, data.faces.size());
+        vertex_count_ = data.vertices.size();
+        face_count_ = data.faces.size();
+        byte_count_ = data.byteCount();
+        data.modified = false;
+    }
 public:
     Mesh() {
         buffer = create_buffer();
-        modified = true;
     }
 
-    Mesh(Mesh &&m) {
+    /**
+     * Move constructor.
+     * Takes ownership of the mesh data and GPU buffer of the original mesh,
+     * which no longer owns a buffer.
+     */
+    Mesh(Mesh &&m): MeshData<>((MeshData<> &&) m) {
         buffer = m.buffer;
-        modified = m.modified;
-        vertices = m.vertices;
-        normals = m.normals;
-        texture_coords = m.texture_coords;
-        faces = m.faces;
+        vertex_count_ = m.vertex_count_;
+        face_count_ = m.face_count_;
+        byte_count_ = m.byte_count_;
         m.buffer = -1;
     }
 
-    Mesh& operator=(Mesh &&m) = default;
+    /**
+     * Move assignment operator.
+     * Deletes the GPU buffer of this mesh and takes ownership of the mesh
+     * data and GPU buffer of the original mesh.
+     */
+    Mesh& operator=(Mesh &&m) {
+        if (this != &m) {
+            if (buffer != -1) {
+                delete_buffer(buffer);
+            }
+            MeshData<>::operator=((MeshData<> &&) m);
+            buffer = m.buffer;
+            vertex_count_ = m.vertex_count_;
+            face_count_ = m.face_count_;
+            byte_count_ = m.byte_count_;
+            m.buffer = -1;
+        }
+        return *this;
+    }
+
+    Mesh(const Mesh &m) = delete;
     Mesh& operator=(const Mesh &m) = delete;
 
-    void clear() {
-        vertices.clear();
-        normals.clear();
-        texture_coords.clear();
-        faces.clear();
+    /**
+     * Returns the number of vertices in the mesh as of the last upload.
+     */
+    unsigned int vertexCount() {
+        return vertex_count_;
     }
-    
-    void appendVertex(const Array<float, 3> &v) {
-        vertices.append(v);
-        modified = true;
+
+    /**
+     * Returns the number of faces in the mesh as of the last upload.
+     */
+    unsigned int faceCount() {
+        return face_count_;
     }
 
-    void appendNormal(const Array<float, 3> &v) {
-        normals.append(v);
-        modified = true;
+    /**
+     * Returns the number of bytes of vertex and index data uploaded to the
+     * GPU by the last upload.
+     */
+    unsigned int byteCount() {
+        return byte_count_;
     }
 
     void setTexture(int i) {
         update_texture(buffer, i);
     }
-    
-    void appendTextureCoord(const Array<float, 2> &v) {
-        texture_coords.append(v);
-        modified = true;
+
+    /**
+     * Uploads the given mesh data to the GPU buffer of this mesh.
+     */
+    template <typename Allocator> void update(MeshData<Allocator> &data) {
+        stageVertices(data);
+        update_vertex_buffer(buffer, &vertex_staging_region, data.vertices.size());
+        updateFaces(data);
     }
 
-    void appendFace(const Array<unsigned short, 3> &f) {
-        faces.append(f);
-        modified = true;
+    /**
+     * Uploads the given packed mesh data to the GPU buffer of this mesh. The
+     * vertex positions are relative to the block (x, y, z).
+     */
+    template <typename Allocator> void update(MeshData<Allocator, PackedVertex> &data, int x, int y, int z) {
+        stageVertices(data);
+        update_packed_vertex_buffer(buffer, &vertex_staging_region, data.vertices.size(), x, y, z);
+        updateFaces(data);
     }
 
+    /**
+     * Uploads the mesh data stored in this mesh if it has been modified.
+     */
     void update() {
         if (modified) {
-            update_vertex_buffer(buffer, (float *) vertices.buffer(), vertices.size());
-            update_normal_buffer(buffer, (float *) normals.buffer(), normals.size());
-            update_texture_buffer(buffer, (float *) texture_coords.buffer(), texture_coords.size());
-            update_index_buffer(buffer, (unsigned short *) faces.buffer()/*(unsigned short *) faces.buffer()*/, faces.size());
+            update(*this);
         }
-        modified = false;
     }
 
     void draw(mat4_t *model_view_matrix, mat4_t *projection_matrix) {
@@ -144,9 +283,11 @@ public:
                     int vt1 = File::nextInt();
                     File::next("/");
                     int vn1 = File::nextInt();
-                    mesh_.appendVertex(vertices[v1 - 1] );
-                    mesh_.appendTextureCoord(texture_coords[vt1 - 1]);
-                    mesh_.appendNormal(normals[vn1 - 1]);
+                    mesh_.appendVertex({
+                        vertices[v1 - 1],
+                        normals[vn1 - 1],
+                        texture_coords[vt1 - 1]
+                    });
                     face_count++;
                 }              
 
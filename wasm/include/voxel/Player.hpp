@@ -46,12 +46,12 @@ public:
 public:
     Player(World *world);
     void setPosition(float x, float y, float z);
-    void draw(mat4_t *projection_matrix) {
-        voxel::Matrix model_view_matrix = getModelViewMatrix();
+    void draw(mat4_t *projection_matrix, float alpha) {
+        voxel::Matrix model_view_matrix = getModelViewMatrix(alpha);
         voxel::Matrix matrix = (voxel::Matrix::Translate({0, 0, 0}) * model_view_matrix).tranpose();
         mesh->draw((mat4_t*) &matrix, projection_matrix);
     }
-    voxel::Matrix getModelViewMatrix();
+    voxel::Matrix getModelViewMatrix(float alpha);
    
     voxel::Array<float, 2> chunk() {
         int chunkX = floor((float) physics_object.position.x / 2 / 16);
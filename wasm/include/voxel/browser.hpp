@@ -24,10 +24,34 @@ extern "C" void send(void *data, size_t size);
  * Returns a random float in the range [0, 1).
  */
 extern "C" float random();
+
+/**
+ * Returns a timestamp in milliseconds for measuring elapsed time.
+ */
+extern "C" double now();
 extern "C" void update_health(int);
 extern "C" int is_key_pressed(int);
 extern "C" void on_key_press(struct World *, int);
 // extern "C" voidf fetch(const char *, char *,);
+
+/**
+ * Returns the size in bytes of the named file in persistent storage, or zero
+ * if the file does not exist.
+ */
+extern "C" int storage_size(const char *name);
+
+/**
+ * Reads up to `length` bytes starting at `offset` of the named file in
+ * persistent storage into `buffer`.
+ * \returns the number of bytes read.
+ */
+extern "C" int storage_read(const char *name, void *buffer, int offset, int length);
+
+/**
+ * Writes `length` bytes from `buffer` to the named file in persistent storage
+ * starting at `offset`. The file is created or extended as necessary.
+ */
+extern "C" void storage_write(const char *name, const void *buffer, int offset, int length);
 extern "C" void print_char(char);
 extern "C" void print_float(float f);
 
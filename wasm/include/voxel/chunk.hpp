@@ -3,15 +3,28 @@
 
 #include <libc/stdint.hpp>
 #include <voxel/physics_object.hpp>
+#include <voxel/frustum.hpp>
 #include <voxel/Mesh.hpp>
+#include <util/Arena.hpp>
 #include <voxel/Matrix.hpp>
 
 #define CHUNK_SIZE 16
 #define CHUNK_HEIGHT 256
+#define SECTION_HEIGHT 16
+#define SECTION_COUNT (CHUNK_HEIGHT / SECTION_HEIGHT)
+#define FACE_COUNT 6
+#define ALL_FACES ((1 << FACE_COUNT) - 1)
 
 float max(float a, float b);
 extern int block_texture_index[][6][2];
 
+/**
+ * The unit step in block coordinates out of each face of a block, indexed by
+ * the bit position of the face in the Face enum. The opposite of face f is
+ * face f ^ 1.
+ */
+extern const int face_directions[FACE_COUNT][3];
+
 class Block {
 public:
     static voxel::Mesh* blocks[256];
@@ -25,6 +38,14 @@ public:
     constexpr Block(Value v): value_{v} {};
     constexpr bool operator==(Block b) const { return value_ == b.value_; }
     constexpr bool operator!=(Block b) const { return value_ != b.value_; }
+
+    /**
+     * Returns true if the block obstructs movement and block selection.
+     */
+    constexpr bool solid() const {
+        return value_ != Value::Air && value_ != Value::Water;
+    }
+
     voxel::Array<float, 2> textureIndex(Face face) {
         switch (value_) {
             case Value::Stone:
@@ -51,26 +72,229 @@ public:
                 return {((int) value_) % 16, ((int) value_) / 16};
         }
     };  
-    explicit operator int() { return value_; }
+    explicit operator int() const { return value_; }
 private:
     Value value_;
 };
 
-struct Chunk {
+/**
+ * Palette-compressed storage for the blocks of a single chunk section.
+ *
+ * A section containing a single block type, such as an all-air section above
+ * the terrain or an all-stone section below it, stores only that block and no
+ * per-block data. Otherwise, each block is stored as a 1, 2, or 4 bit index
+ * into a palette of at most PALETTE_CAPACITY block types. Sections with more
+ * block types than that store one byte per block directly.
+ *
+ * The packed data is heap allocated, so moving a BlockStorage is O(1).
+ */
+class BlockStorage {
+public:
+    const static int VOLUME = CHUNK_SIZE * SECTION_HEIGHT * CHUNK_SIZE;
+    const static int PALETTE_CAPACITY = 16;
+
 private:
-    World *world;
-    Block blocks[CHUNK_SIZE][CHUNK_HEIGHT][CHUNK_SIZE];
-    voxel::ArrayList<aabb3_t> physics_objects_;
+    uint8_t *data_ = nullptr;
+    uint8_t bits_ = 0;
+    uint8_t palette_size_ = 1;
+    Block palette_[PALETTE_CAPACITY] = {Block::Air};
+
+    static int index(int x, int y, int z) {
+        return (x * SECTION_HEIGHT + y) * CHUNK_SIZE + z;
+    }
+
+    static int readPacked(const uint8_t *data, int bits, int i) {
+        int bit = i * bits;
+        return (data[bit >> 3] >> (bit & 7)) & ((1 << bits) - 1);
+    }
+
+    static void writePacked(uint8_t *data, int bits, int i, int value) {
+        int bit = i * bits;
+        uint8_t mask = ((1 << bits) - 1) << (bit & 7);
+        data[bit >> 3] = (data[bit >> 3] & ~mask) | ((value << (bit & 7)) & mask);
+    }
+
+    void repack(int bits);
+
+public:
+    BlockStorage() = default;
+    BlockStorage(const BlockStorage &) = delete;
+    BlockStorage &operator=(const BlockStorage &) = delete;
+
+    BlockStorage(BlockStorage &&storage) {
+        *this = (BlockStorage &&) storage;
+    }
+
+    BlockStorage &operator=(BlockStorage &&storage) {
+        if (this != &storage) {
+            free(data_);
+            data_ = storage.data_;
+            bits_ = storage.bits_;
+            palette_size_ = storage.palette_size_;
+            for (int i = 0; i < PALETTE_CAPACITY; i++) {
+                palette_[i] = storage.palette_[i];
+            }
+            storage.data_ = nullptr;
+            storage.bits_ = 0;
+            storage.palette_size_ = 1;
+            storage.palette_[0] = Block::Air;
+        }
+        return *this;
+    }
+
+    ~BlockStorage() {
+        free(data_);
+    }
+
+    /**
+     * Returns true if every block in the section is the same block type.
+     */
+    bool uniform() const {
+        return bits_ == 0;
+    }
+
+    /**
+     * Returns the block at the given section-local coordinates.
+     */
+    Block get(int x, int y, int z) const {
+        if (bits_ == 0) return palette_[0];
+        int i = readPacked(data_, bits_, index(x, y, z));
+        if (bits_ == 8) return (Block::Value) i;
+        return palette_[i];
+    }
+
+    /**
+     * Sets the block at the given section-local coordinates. If the block is
+     * not yet in the palette, it is added and the packed data is widened as
+     * required.
+     */
+    void set(int x, int y, int z, Block b);
+
+    /**
+     * Removes unused block types from the palette and narrows the packed data
+     * to the fewest bits that can index the remaining palette. A section which
+     * has become uniform releases its packed data entirely.
+     */
+    void compact();
+
+    /**
+     * Returns the number of heap bytes used by the packed block data.
+     */
+    unsigned int byteCount() const {
+        return VOLUME * bits_ / 8;
+    }
+
+    /**
+     * Appends the packed representation of the section to the given buffer:
+     * the bits per block, the palette size, the palette, and the packed data.
+     */
+    void save(voxel::ArrayList<uint8_t> &out) const;
+
+    /**
+     * Restores the section from a buffer written by `save`.
+     * \returns the number of bytes read, or -1 if the buffer is malformed.
+     */
+    int load(const uint8_t *data, unsigned int length);
+};
+
+/**
+ * The algorithm used to build chunk meshes.
+ * A naive mesh contains one quad per visible block face. A greedy mesh merges
+ * adjacent coplanar faces of the same block type into larger quads.
+ */
+enum MeshMode {
+    Naive,
+    Greedy,
+};
+
+/**
+ * Scratch memory for building chunk meshes. Mesh data is built in this arena
+ * and uploaded to the GPU directly from it, after which the arena is reset,
+ * so rebuilding a mesh neither copies its data nor holds on to or fragments
+ * heap memory.
+ */
+extern voxel::Arena chunk_mesh_arena;
+
+typedef voxel::MeshData<voxel::ArenaAllocator<chunk_mesh_arena>, voxel::PackedVertex> ChunkMeshData;
+
+/**
+ * A SECTION_HEIGHT tall horizontal slice of a chunk. Each section owns its
+ * meshes and is rebuilt independently, so a block update only rebuilds the
+ * sections whose visible faces it can change.
+ */
+struct ChunkSection {
+    BlockStorage blocks;
     voxel::Mesh opaque_mesh;
     voxel::Mesh transparent_mesh;
     bool update_;
 
+    /**
+     * The faces of the section which can see each other through the section.
+     * Bit g of connectivity[f] is set if some path of transparent blocks
+     * connects face f to face g. A section is fully connected until it is
+     * first computed.
+     */
+    uint8_t connectivity[FACE_COUNT] = {ALL_FACES, ALL_FACES, ALL_FACES, ALL_FACES, ALL_FACES, ALL_FACES};
+
+    ChunkSection() = default;
+
+    ChunkSection(ChunkSection &&section) {
+        blocks = (BlockStorage &&) section.blocks;
+        opaque_mesh = (voxel::Mesh &&) section.opaque_mesh;
+        transparent_mesh = (voxel::Mesh &&) section.transparent_mesh;
+        update_ = section.update_;
+        for (int f = 0; f < FACE_COUNT; f++) {
+            connectivity[f] = section.connectivity[f];
+        }
+    }
+
+    ChunkSection& operator=(ChunkSection &&section) = default;
+};
+
+struct Chunk {
 private:
-    void computeMesh();
-    void computePhysicsObjects();
+    World *world;
+    ChunkSection sections_[SECTION_COUNT];
+    uint8_t heightmap_[CHUNK_SIZE][CHUNK_SIZE];
+    bool saved_;
+
+    /**
+     * A bitmask of the sections drawn by `draw_opaque` and
+     * `draw_transparent`, as computed by the last call to `cull`.
+     */
+    uint16_t visible_sections_ = 0;
+
+    /**
+     * The sections reached by the occlusion culling search of the current
+     * frame, and the faces through which each section has been entered.
+     */
+    uint16_t reachable_sections_ = 0;
+    uint8_t entered_faces_[SECTION_COUNT] = {0};
+
+private:
+    /**
+     * Stores a block without notifying any sections of the change. This is
+     * used during terrain generation, before the chunk has been meshed.
+     */
+    void storeBlock(int x, int y, int z, Block b) {
+        sections_[y / SECTION_HEIGHT].blocks.set(x, y % SECTION_HEIGHT, z, b);
+    }
+
+    void computeMesh(int section);
+    void computeNaiveMesh(int section, ChunkMeshData &opaque, ChunkMeshData &transparent);
+    void computeGreedyMesh(int section, ChunkMeshData &opaque, ChunkMeshData &transparent);
+    void computeConnectivity(int section);
+    void computeHeightmap();
+    void scanHeightmap();
+    void scanColumn(int x, int z, int y);
 
 public:
 
+    /**
+     * The algorithm used by all chunks when rebuilding their meshes.
+     */
+    static MeshMode mesh_mode;
+
     /**
      * The chunk coordinates.
      * TODO: make private and add getter methods.
@@ -85,29 +309,83 @@ public:
      */
     Chunk(struct World *w, int x, int z, uint32_t seed);
 
+    /**
+     * Constructs an empty chunk consisting entirely of air. This is used to
+     * restore a saved chunk with `load`.
+     */
+    Chunk(struct World *w, int x, int z);
+
     Chunk(Chunk &&chunk) {
         world = chunk.world;
+        chunk_x = chunk.chunk_x;
+        chunk_z = chunk.chunk_z;
+        saved_ = chunk.saved_;
+        visible_sections_ = chunk.visible_sections_;
+        reachable_sections_ = chunk.reachable_sections_;
+        for (int s = 0; s < SECTION_COUNT; s++) {
+            entered_faces_[s] = chunk.entered_faces_[s];
+        }
         for (int x = 0; x < CHUNK_SIZE; x++) {
-            for (int y = 0; y < CHUNK_HEIGHT; y++) {
-                for (int z = 0; z < CHUNK_SIZE; z++) {
-                    blocks[x][y][z] = chunk.blocks[x][y][z];
-                }
-            }  
+            for (int z = 0; z < CHUNK_SIZE; z++) {
+                heightmap_[x][z] = chunk.heightmap_[x][z];
+            }
+        }
+        for (int s = 0; s < SECTION_COUNT; s++) {
+            sections_[s] = (ChunkSection &&) chunk.sections_[s];
         }
-        physics_objects_ = (voxel::ArrayList<aabb3_t>&&) chunk.physics_objects_;
-        opaque_mesh = (voxel::Mesh &&) chunk.opaque_mesh;
-        transparent_mesh = (voxel::Mesh &&) chunk.transparent_mesh;
-        update_ = chunk.update_;
     }
 
     Chunk& operator=(Chunk &&m) = default;
 
     /**
-     * Recompute mesh and list of active physics objects if any block changes
-     * have occured since the last update.
+     * Recompute the mesh and connectivity of every section in which block
+     * changes have occured since the last update.
      */
     void update();
 
+    /**
+     * Marks every section of the chunk as modified so that its mesh is
+     * recomputed on the next call to `update`.
+     */
+    void invalidate() {
+        for (int s = 0; s < SECTION_COUNT; s++) {
+            sections_[s].update_ = true;
+        }
+    }
+
+    /**
+     * Marks a single section of the chunk as modified.
+     */
+    void invalidate(int section) {
+        sections_[section].update_ = true;
+    }
+
+    /**
+     * Returns the number of vertices in the opaque and transparent meshes of
+     * the chunk as of the last mesh rebuild.
+     */
+    unsigned int vertexCount() {
+        unsigned int count = 0;
+        for (int s = 0; s < SECTION_COUNT; s++) {
+            count += sections_[s].opaque_mesh.vertexCount();
+            count += sections_[s].transparent_mesh.vertexCount();
+        }
+        return count;
+    }
+
+    /**
+     * Returns the number of bytes of mesh data uploaded for the chunk as of
+     * the last mesh rebuild.
+     */
+    unsigned int byteCount() {
+        unsigned int bytes = 0;
+        for (int s = 0; s < SECTION_COUNT; s++) {
+            bytes += sections_[s].opaque_mesh.byteCount();
+            bytes += sections_[s].transparent_mesh.byteCount();
+        }
+        return bytes;
+    }
+
     int x() {
         return chunk_x;
     }
@@ -122,7 +400,51 @@ public:
      * dimensions and 0 and CHUNK_HEIGHT in the y dimension.
      */
     Block getBlock(int x, int y, int z) {
-        return blocks[x][y][z];
+        return sections_[y / SECTION_HEIGHT].blocks.get(x, y % SECTION_HEIGHT, z);
+    }
+
+    /**
+     * Returns the surface height of the given column in local chunk
+     * coordinates: the y coordinate of the first block above the surface.
+     * For a generated chunk this is the terrain height, excluding water and
+     * trees; for a chunk loaded from a region file it is the height of the
+     * top solid block as saved. The height is cached when the chunk is
+     * created or loaded and kept current by `setBlock`, so this does not
+     * evaluate the noise function.
+     */
+    int surfaceHeight(int x, int z) {
+        return heightmap_[x][z];
+    }
+
+    /**
+     * Returns true if the chunk has not been modified since it was last saved
+     * or loaded.
+     */
+    bool saved() {
+        return saved_;
+    }
+
+    /**
+     * Appends the blocks of the chunk to the given buffer in the format used
+     * by region files.
+     */
+    void save(voxel::ArrayList<uint8_t> &out);
+
+    /**
+     * Restores the blocks of the chunk from a buffer written by `save`.
+     * \returns false if the buffer is malformed.
+     */
+    bool load(const uint8_t *data, unsigned int length);
+
+    /**
+     * Returns the number of heap bytes used to store the blocks of the chunk.
+     */
+    unsigned int blockByteCount() {
+        unsigned int bytes = 0;
+        for (int s = 0; s < SECTION_COUNT; s++) {
+            bytes += sections_[s].blocks.byteCount();
+        }
+        return bytes;
     }
 
     /**
@@ -144,28 +466,117 @@ public:
     int isBlockVisible(int x, int y, int z) ;
 
     /**
-     * Return a reference to the list of active physics objects. This list does
-     * not contain a physics object for every block... it only contains physics
-     * objects for visible blocks - block which touch at least one transparent
-     * block such as air or water.
+     * Returns the bounding box of the chunk in world space. Blocks are two
+     * units wide and centered on even coordinates.
+     */
+    aabb3_t bounds() {
+        aabb3_t box;
+        vec3_init(&box.size, CHUNK_SIZE, CHUNK_HEIGHT, CHUNK_SIZE);
+        vec3_init(&box.position, 2 * chunk_x * CHUNK_SIZE + CHUNK_SIZE - 1, CHUNK_HEIGHT - 1, 2 * chunk_z * CHUNK_SIZE + CHUNK_SIZE - 1);
+        return box;
+    }
+
+    /**
+     * Returns the bounding box of the given section in world space.
+     */
+    aabb3_t sectionBounds(int section) {
+        aabb3_t box = bounds();
+        box.size.y = SECTION_HEIGHT;
+        box.position.y = 2 * section * SECTION_HEIGHT + SECTION_HEIGHT - 1;
+        return box;
+    }
+
+    /**
+     * Returns true if face `from` of the given section can see face `to`
+     * through the transparent blocks of the section.
      */
-    voxel::ArrayList<aabb3_t>& physicsObjects() {
-        return physics_objects_;
+    bool sectionConnects(int section, int from, int to) {
+        return sections_[section].connectivity[from] & (1 << to);
     }
 
     /**
-     * Draws the chunk from the perspective of the given projection matrix.
-     * Since chunks do not move, the model-view matrix is simply an identity
-     * matrix.
+     * Forgets the sections reached by the occlusion culling search of the
+     * previous frame.
+     */
+    void clearReachable() {
+        reachable_sections_ = 0;
+        for (int s = 0; s < SECTION_COUNT; s++) {
+            entered_faces_[s] = 0;
+        }
+    }
+
+    /**
+     * Marks the given section as reached by the occlusion culling search
+     * through the given face, or from within if `face` is -1.
+     * \returns false if the section had already been entered through the face.
+     */
+    bool enterSection(int section, int face) {
+        uint8_t bit = face < 0 ? ALL_FACES: 1 << face;
+        if ((entered_faces_[section] & bit) == bit) {
+            return false;
+        }
+        entered_faces_[section] |= bit;
+        reachable_sections_ |= 1 << section;
+        return true;
+    }
+
+    /**
+     * Determines which sections of the chunk are reachable by the occlusion
+     * culling search and intersect the given view frustum, and records the
+     * result in the given counters. Only these sections are drawn until the
+     * next call to `cull`. Sections without any faces are never drawn and
+     * are not counted as culled.
+     */
+    void cull(const frustum_t *frustum, cull_stats_t *stats) {
+        visible_sections_ = 0;
+        stats->chunks_considered++;
+        aabb3_t box = bounds();
+        if (!frustum_intersects_aabb(frustum, &box)) {
+            stats->chunks_culled++;
+            return;
+        }
+        for (int s = 0; s < SECTION_COUNT; s++) {
+            ChunkSection &section = sections_[s];
+            if (section.opaque_mesh.faceCount() == 0 && section.transparent_mesh.faceCount() == 0) {
+                continue;
+            }
+            box = sectionBounds(s);
+            if (!frustum_intersects_aabb(frustum, &box)) {
+                stats->sections_culled++;
+            } else if (!(reachable_sections_ & (1 << s))) {
+                stats->sections_occluded++;
+            } else {
+                visible_sections_ |= 1 << s;
+                stats->sections_drawn++;
+            }
+        }
+        if (visible_sections_ != 0) {
+            stats->chunks_drawn++;
+        }
+    }
+
+    /**
+     * Draws the visible sections of the chunk from the perspective of the
+     * given projection matrix. Since chunks do not move, the model-view
+     * matrix is simply an identity matrix. Sections without any faces are
+     * skipped.
      */
     void draw_opaque(mat4_t *projection) {
         voxel::Matrix identity = voxel::Matrix::identity();
-        opaque_mesh.draw((mat4_t *) &identity, projection);
+        for (int s = 0; s < SECTION_COUNT; s++) {
+            if ((visible_sections_ & (1 << s)) && sections_[s].opaque_mesh.faceCount() > 0) {
+                sections_[s].opaque_mesh.draw((mat4_t *) &identity, projection);
+            }
+        }
     }
 
     void draw_transparent(mat4_t *projection) {
         voxel::Matrix identity = voxel::Matrix::identity();
-        transparent_mesh.draw((mat4_t *) &identity, projection);
+        for (int s = 0; s < SECTION_COUNT; s++) {
+            if ((visible_sections_ & (1 << s)) && sections_[s].transparent_mesh.faceCount() > 0) {
+                sections_[s].transparent_mesh.draw((mat4_t *) &identity, projection);
+            }
+        }
     }
 };
 
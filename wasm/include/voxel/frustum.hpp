@@ -0,0 +1,72 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+/**
+ * \file frustum.h
+ * \brief View frustum culling.
+ * \author Thomas Barrett <tbarrett@caltech.edu>
+ * \date Dec 12, 2019
+ */
+
+#include <voxel/linalg.hpp>
+#include <voxel/physics_object.hpp>
+
+/**
+ * A plane given by the equation dot(normal, p) + distance = 0. Points with a
+ * positive signed distance lie on the side of the plane that the normal
+ * points to.
+ */
+typedef struct plane3 {
+    vec3_t normal;
+    float distance;
+} plane3_t;
+
+/**
+ * The region of space visible to the camera, bounded by six planes whose
+ * normals point into the frustum: left, right, bottom, top, near and far.
+ */
+typedef struct frustum {
+    plane3_t planes[6];
+} frustum_t;
+
+/**
+ * Counts of the chunks and sections handled while drawing a frame.
+ * A chunk is considered when it lies within drawing distance of the player,
+ * and is culled when it lies entirely outside the view frustum. The
+ * non-empty sections of the remaining chunks are then either occluded,
+ * culled, or drawn, and each section drawn issues one draw call per
+ * non-empty mesh.
+ */
+typedef struct cull_stats {
+    unsigned int chunks_considered;
+    unsigned int chunks_culled;
+    unsigned int chunks_drawn;
+    unsigned int sections_occluded;
+    unsigned int sections_culled;
+    unsigned int sections_drawn;
+} cull_stats_t;
+
+/**
+ * Extracts the planes of the view frustum from a combined projection and
+ * view matrix, such as the one built by `world_get_projection_matrix`.
+ * A point p is visible when each of the clip coordinates x, y and z of
+ * M * p lies between -w and w, and each of these six inequalities is a
+ * plane in world space.
+ * \param self: The frustum to initialize.
+ * \param m: The matrix mapping world coordinates to clip coordinates.
+ */
+void frustum_init(frustum_t *self, const mat4_t *m);
+
+/**
+ * Returns 1 if the given axis-aligned bounding box may be visible.
+ * The box is tested against each plane in turn using the corner of the box
+ * farthest along the plane normal. The test is conservative: a box which
+ * lies outside the frustum near one of its edges may still be reported as
+ * visible, but a visible box is never rejected.
+ * \param self: The frustum.
+ * \param box: The box.
+ * \returns 0 if the box lies entirely outside the frustum and 1 otherwise.
+ */
+int frustum_intersects_aabb(const frustum_t *self, const aabb3_t *box);
+
+#endif /* FRUSTUM_H */
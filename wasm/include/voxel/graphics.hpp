@@ -1,16 +1,35 @@
 #ifndef GRAPHICS_H
 #define GRAPHICS_H
 
+#include <libc/stdint.hpp>
 #include <voxel/linalg.hpp>
+#include <voxel/staging.hpp>
 
 extern "C" void on_animation_frame(struct World *world, float dt, float aspect);
 extern "C" void draw(float *vertices, int n_vertices, unsigned short *faces, int n_faces, mat4_t *model);
 
 extern "C" int create_buffer();
-extern "C" void update_vertex_buffer(int, float*, int);
-extern "C" void update_normal_buffer(int, float*, int);
-extern "C" void update_index_buffer(int, unsigned short*, int);
-extern "C" void update_texture_buffer(int, float*, int);
+
+/**
+ * Resizes the vertex buffer of the given buffer to hold `n_vertices`
+ * interleaved vertices (see voxel::Vertex) and uploads the contents of the
+ * staging region to it.
+ */
+extern "C" void update_vertex_buffer(int, staging_region_t*, int);
+
+/**
+ * Resizes the vertex buffer of the given buffer to hold `n_vertices` packed
+ * vertices (see voxel::PackedVertex) and uploads the contents of the
+ * staging region to it. Vertex positions are relative to the block (x, y, z),
+ * which is passed to the shader when the buffer is drawn.
+ */
+extern "C" void update_packed_vertex_buffer(int, staging_region_t*, int, int x, int y, int z);
+
+/**
+ * Resizes the index buffer of the given buffer to hold `n_faces` triangles
+ * and uploads the contents of the staging region to it.
+ */
+extern "C" void update_index_buffer(int, staging_region_t*, int);
 extern "C" void update_texture(int, int);
 extern "C" void delete_buffer(int);
 extern "C" void draw_buffer(int, mat4_t*, mat4_t*);
@@ -81,6 +81,16 @@ void vec3_div(const vec3_t *a, const vec3_t *b, vec3_t *c);
  */
 void vec3_scale(const vec3_t *a, float b, vec3_t *c);
 
+/**
+ * Linearly interpolates between two vectors and stores the result in a third
+ * vector.
+ * \param a: The vector at t = 0.
+ * \param b: The vector at t = 1.
+ * \param t: The interpolation parameter.
+ * \param c: The output vector.
+ */
+void vec3_lerp(const vec3_t *a, const vec3_t *b, float t, vec3_t *c);
+
 /**
  * Returns the euclidian distance between two vectors.
  * \param a: The first input vector.
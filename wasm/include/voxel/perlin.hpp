@@ -3,4 +3,27 @@
 
 extern double perlin2d(double x, double y, double freq, int depth);
 
+/**
+ * Evaluates perlin2d at every integer coordinate of a width by height grid
+ * starting at (x, y) and stores the results in `out` in row major order, so
+ * that out[j * width + i] corresponds to perlin2d(x + i, y + j, freq, depth).
+ *
+ * The grid is evaluated one row and octave at a time in single precision,
+ * with the per-sample arithmetic separated from the hash table lookups so
+ * that it can be auto-vectorized (wasm SIMD128, SSE, or NEON). Results agree
+ * with perlin2d to within PERLIN_GRID_TOLERANCE for |x|, |y| < 2^16.
+ */
+extern void perlin2d_grid(float *out, int x, int y, int width, int height, double freq, int depth);
+
+#define PERLIN_GRID_TOLERANCE 1e-4
+
+/**
+ * Compares the throughput of perlin2d and perlin2d_grid by generating
+ * `iterations` 16x16 grids with each, and prints the time taken by each in
+ * milliseconds followed by the largest absolute difference between them
+ * over all of the grids. Nothing is printed if `iterations` is less than one.
+ * This is intended to be called from the browser console.
+ */
+extern "C" void perlin_benchmark(int iterations);
+
 #endif  // PERLIN_H
\ No newline at end of file
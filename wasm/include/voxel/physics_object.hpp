@@ -48,11 +48,16 @@ typedef struct aabb3 {
  * player. In the case of colliding dyn_aabb3_t, it might be important to
  * consider the mass of a dyn_aabb3_t. Future updates might require a mass
  * field to be added.
+ * 
+ * The position at the start of the last physics step is kept in
+ * previous_position, so that the body can be drawn between its last two
+ * simulated positions (see dyn_aabb3_interpolate).
  */
 typedef struct dyn_aabb3 {
     vec3_t position;
     vec3_t size;
     vec3_t velocity;
+    vec3_t previous_position;
 } dyn_aabb3_t;
 
 /**
@@ -67,6 +72,16 @@ typedef struct ray3 {
 } ray3_t;
 
 
+/**
+ * The result of intersecting a ray with an object: the side of the object
+ * which the ray hit, given as the side facing the positive or negative
+ * direction of each axis (Right and Left for x, Top and Bottom for y, Back
+ * and Front for z), and the distance along the ray to the hit.
+ *
+ * A result from `ray_intersects` refers to the bounding box that was hit,
+ * while a result from a voxel raycast refers to the world coordinates of the
+ * block that was hit.
+ */
 struct IntersectionResult {
 public:
     enum Value: int { 
@@ -74,7 +89,8 @@ public:
     };
 
     IntersectionResult() = default;
-    constexpr IntersectionResult(Value v, float t, aabb3_t *b): value_{v}, time_{t}, block_{b} {};
+    constexpr IntersectionResult(Value v, float t, aabb3_t *b): value_{v}, block_{b}, time_{t} {};
+    constexpr IntersectionResult(Value v, float t, int x, int y, int z): value_{v}, block_{nullptr}, time_{t}, x_{x}, y_{y}, z_{z} {};
     constexpr bool operator==(IntersectionResult b) const { return value_ == b.value_; }
     constexpr bool operator!=(IntersectionResult b) const { return value_ != b.value_; }
     explicit operator int() { return value_; }
@@ -84,10 +100,22 @@ public:
     aabb3_t* block() {
         return block_;
     }
+    int x() const {
+        return x_;
+    }
+    int y() const {
+        return y_;
+    }
+    int z() const {
+        return z_;
+    }
 private:
     Value value_;
     aabb3_t *block_;
     float time_;
+    int x_ = 0;
+    int y_ = 0;
+    int z_ = 0;
 };
 
 /**
@@ -119,13 +147,23 @@ int aabb3_intersects(const aabb3_t *a, const aabb3_t *b);
  */
 int aabb3_contains(const aabb3_t *a, const vec3_t *b);
 
+/**
+ * Computes the position at which a dynamic physics object is drawn, a
+ * fraction `alpha` of the way from its previous position to its current one.
+ * \param a: The physics object.
+ * \param alpha: The fraction of a physics step elapsed since the last step.
+ * \param position: The interpolated position.
+ */
+void dyn_aabb3_interpolate(const dyn_aabb3_t *a, float alpha, vec3_t *position);
+
 /**
  * Corrects the position of two intersection physics objects so that they are
  * no longer intersecting.
  * 
  * The algorithm in use is naiive, and if the physics engine is not updated
  * frequently enough, it is possible for a dynamic object to 'phase' through
- * another one.
+ * another one. Bodies moving through the world should therefore be moved with
+ * world_move_body, which sweeps them against the block grid.
  * 
  * TODO: After collision resolution, it can be useful to know more information
  * about the collision such as the collision normal (direction of collision).
@@ -0,0 +1,52 @@
+#ifndef VOXEL_REGION_HPP
+#define VOXEL_REGION_HPP
+
+/**
+ * \file region.hpp
+ * \brief Persistent storage of chunks in region files.
+ * \author Thomas Barrett <tbarrett@caltech.edu>
+ * \date Dec 12, 2019
+ */
+
+#include <voxel/Chunk.hpp>
+
+/**
+ * The number of chunks along each side of a region. A region file stores up
+ * to REGION_SIZE * REGION_SIZE chunks.
+ */
+#define REGION_SIZE 16
+
+/**
+ * A region file begins with an offset table containing one entry for each
+ * chunk in the region. Each entry stores the byte offset and length of the
+ * chunk payload within the file, along with the capacity of the slot
+ * reserved for it. An offset of zero indicates that the chunk has not been
+ * saved. Chunk payloads follow the table. Each payload is the palette packed
+ * block data written by Chunk::save, compressed with a run length encoding.
+ *
+ * Saving a chunk overwrites its slot in place when the payload fits, so a
+ * chunk which is evicted repeatedly does not grow the file. A payload which
+ * does not fit is appended to the end of the file, and the table entry is
+ * updated to point at the new, larger slot.
+ */
+struct region_entry_t {
+    uint32_t offset;
+    uint32_t length;
+    uint32_t capacity;
+};
+
+#define REGION_TABLE_SIZE (REGION_SIZE * REGION_SIZE * sizeof(region_entry_t))
+
+/**
+ * Loads the chunk at the given chunk coordinates from its region file.
+ * \returns the loaded chunk, or nullptr if the chunk has never been saved or
+ * its payload could not be read.
+ */
+Chunk* region_load_chunk(struct World *world, int x, int z);
+
+/**
+ * Saves the given chunk to its region file.
+ */
+void region_save_chunk(Chunk *chunk);
+
+#endif /* VOXEL_REGION_HPP */
@@ -0,0 +1,41 @@
+#ifndef VOXEL_STAGING_HPP
+#define VOXEL_STAGING_HPP
+
+/**
+ * \file staging.hpp
+ * \brief Descriptors of memory read by javascript for GPU uploads.
+ * \author Thomas Barrett <tbarrett@caltech.edu>
+ * \date Dec 12, 2019
+ */
+
+#include <libc/stdint.hpp>
+
+/**
+ * A staging region is a plain pointer and length describing memory from which
+ * buffer data is uploaded to the GPU. Mesh data is never copied into a
+ * separate upload buffer: a mesh points the region at the memory in which it
+ * was built, such as the chunk mesh arena, with staging_map, and javascript
+ * uploads all `size` bytes straight from that memory. No dirty range is
+ * tracked, since a rebuilt mesh replaces the previous one entirely.
+ *
+ * The layout of this struct is read directly by src/gpu.js.
+ */
+struct staging_region_t {
+    uint8_t *data;
+    uint32_t size;
+};
+
+/**
+ * The staging regions used for vertex and index data respectively.
+ */
+extern staging_region_t vertex_staging_region;
+extern staging_region_t index_staging_region;
+
+/**
+ * Points the given staging region at the `size` bytes starting at `data`.
+ * The memory is read in place, so it must not be modified or released until
+ * it has been uploaded.
+ */
+void staging_map(staging_region_t *region, const void *data, uint32_t size);
+
+#endif /* VOXEL_STAGING_HPP */
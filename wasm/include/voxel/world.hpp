@@ -2,31 +2,64 @@
 #define WORLD_H
 
 #include <voxel/physics_object.hpp>
+#include <voxel/frustum.hpp>
 #include <voxel/Player.hpp>
 #include <voxel/Chunk.hpp>
 #include <voxel/Item.hpp>
+#include <util/HashMap.hpp>
 
 #define CHUNK_CAPACITY 1024
 #define VISIBLE_CHUNK_RADIUS 4
 #define PLAYER_COUNT 3
 #define MOB_COUNT 10
+#define TERRAIN_FREQUENCY 0.05
+#define TERRAIN_OCTAVES 3
+
+/**
+ * The physics are simulated in fixed steps of PHYSICS_TIMESTEP seconds. By
+ * default, at most PHYSICS_MAX_STEPS steps are taken per frame.
+ */
+#define PHYSICS_TIMESTEP (1.0f / 60)
+#define PHYSICS_MAX_STEPS 5
+
+/**
+ * An entry of the occlusion culling search: a chunk section, the face through
+ * which it was entered (or -1 for the section containing the camera), and
+ * the set of directions travelled from the camera to reach it.
+ */
+struct SectionVisit {
+    Chunk *chunk;
+    int8_t section;
+    int8_t face;
+    uint8_t directions;
+};
 
 /*
  * Represents an infinite voxel world composed of chunks.
  * Initially a world has no chunks, but up to CHUNK_CAPACITY chunks can be
- * dynamically added to the world.
+ * dynamically added to the world. Once the capacity is reached, the chunks
+ * farthest from the player are evicted to make room for new ones.
  */
 struct World {
 public:
     int chunk_count;
     mat4_t projection_matrix;
+    vec3_t camera_position;
+    float physics_accumulator;
+    float interpolation;
+    int max_physics_steps;
+    frustum_t frustum;
+    cull_stats_t cull_stats;
+    voxel::ArrayList<SectionVisit> visibility_queue_;
     Player player;
     voxel::ArrayList<Chunk*> chunks_;
+    voxel::HashMap<Chunk*> chunk_index_;
     voxel::ArrayList<Player*> mobs_;
     voxel::ArrayList<Item*> items;
 public:
     World();
     static int elevation(int x, int z);
+    static int elevation(float noise);
     static int sea_level();
 };
 
@@ -46,14 +79,88 @@ void world_destroy(struct World *self);
 
 Chunk* world_get_chunk(struct World *self, int x, int z);
 void world_break_block(struct World *self, int x, int y, int z);
+Block world_get_block(struct World *self, int x, int y, int z);
+
+/**
+ * Calls `f(chunk)` for each loaded chunk which overlaps the given box.
+ * The chunks are found by looking up each chunk coordinate covered by the box
+ * in the chunk index, so the cost depends on the size of the box rather than
+ * on the number of loaded chunks. This is the broadphase used for all
+ * collisions between dynamic bodies and the world.
+ */
+template <typename F> void world_query_chunks(struct World *self, const aabb3_t *box, F f) {
+    // Chunk c spans the world coordinates from 2 * CHUNK_SIZE * c - 1 to
+    // 2 * CHUNK_SIZE * (c + 1) - 1 along the x and z axes.
+    int x0 = floor((box->position.x - box->size.x + 1) / (2 * CHUNK_SIZE));
+    int x1 = floor((box->position.x + box->size.x + 1) / (2 * CHUNK_SIZE));
+    int z0 = floor((box->position.z - box->size.z + 1) / (2 * CHUNK_SIZE));
+    int z1 = floor((box->position.z + box->size.z + 1) / (2 * CHUNK_SIZE));
+    for (int x = x0; x <= x1; x++) {
+        for (int z = z0; z <= z1; z++) {
+            Chunk *chunk = world_get_chunk(self, x, z);
+            if (chunk != nullptr) {
+                f(chunk);
+            }
+        }
+    }
+}
+
+/**
+ * Resolves collisions between the given body and the solid blocks of the
+ * world. Only the blocks in the grid cells overlapped by the body are
+ * tested, so the cost depends on the size of the body alone.
+ * \returns the faces of the body which collided with a block.
+ */
+int world_resolve_collisions(struct World *self, dyn_aabb3_t *body);
+
+/**
+ * Moves the given body by its velocity over the time step `dt`, stopping it
+ * against the solid blocks of the world. Each axis is swept in turn, the
+ * vertical axis first, and the body is stopped flush against the first
+ * block in its path, so no block can be skipped however large the step.
+ * A body resting on a block is reported as touching it with its bottom face.
+ * \returns the faces of the body which touched a block, using the same
+ *     convention as `aabb3_resolve_collision`.
+ */
+int world_move_body(struct World *self, dyn_aabb3_t *body, float dt);
+
+/**
+ * Finds the first solid block hit by the given ray within the given distance
+ * by stepping through the block grid along the ray. The ray direction must be
+ * a unit vector. The block containing the origin of the ray is ignored.
+ * \returns the block and side hit, or an IntersectionResult with value None
+ *     if no block was hit.
+ */
+IntersectionResult world_raycast(struct World *self, const ray3_t *ray, float distance);
 int world_get_chunk_count(struct World *self);
 float* world_get_projection_matrix(struct World *self, float aspect);
 Chunk* world_get_chunk_by_index(struct World *self, int i);
 int world_set_chunk(struct World *self, int x, int z, Chunk *chunk);
+void world_remove_chunk(struct World *self, int i);
+void world_evict_chunks(struct World *self);
 aabb3_t *world_ray_intersect(ray3_t *ray, struct World *self);
 
 extern "C" int world_update(struct World *self, float dt);
+
+/**
+ * Advances the simulation by the frame time `dt`. The time is added to an
+ * accumulator from which world_update is run in fixed steps of
+ * PHYSICS_TIMESTEP, so the physics do not depend on the frame rate. If more
+ * than `max_physics_steps` steps are due, the excess time is dropped and the
+ * game runs slower rather than spending ever longer on physics. The time
+ * left in the accumulator sets the interpolation used to draw each body
+ * between its last two simulated positions. Once the steps are taken, the
+ * chunks around the player are loaded and its position is sent to the
+ * server, once per call.
+ * \returns the number of physics steps taken.
+ */
+extern "C" int world_advance(struct World *self, float dt);
+extern "C" void world_set_max_physics_steps(struct World *self, int steps);
 extern "C" void world_click_handler(struct World *self);
 extern "C" void world_move_handler(struct World *self, float dx, float dy);
+extern "C" void world_set_mesh_mode(struct World *self, int mode);
+extern "C" unsigned int world_get_vertex_count(struct World *self);
+extern "C" unsigned int world_get_vertex_bytes(struct World *self);
+extern "C" cull_stats_t* world_get_cull_stats(struct World *self);
 
 #endif /* WORLD_H */
\ No newline at end of file
@@ -6,9 +6,17 @@
  * uint32_t offsets from mem_heap_lo(). In addition, we replace our header
  * with a single uint32_t integer which represents the size of the block.
  * 2^32 bytes should be more than enough for any allocation needs. We utilize
- * the lowest byte - which will always be zero for a 4 or 8 byte aligned
- * address - as the 'free' marker. We maintain alignment by adding a 32 bit
- * offset to the front of the heap and to ensure that two headers will.
+ * the uppermost bit - which will always be zero for any realistic block
+ * size - as the 'free' marker.
+ *
+ * Every block, free or allocated, begins with a header and ends with a
+ * footer, and blocks are laid out contiguously from mem_heap_lo() to
+ * mem_heap_hi(), so the heap can be walked block by block (see mem_doctor).
+ * Free blocks additionally store the offsets of the next and previous
+ * blocks in their free list at the start of their payload. Free blocks are
+ * binned into power of two size classes, so that both inserting and
+ * removing a free block is O(1) and malloc only searches the blocks of a
+ * single size class before falling back to the head of a larger class.
  */
 
 #include <libc/stdint.hpp>
@@ -63,21 +71,108 @@ void* mem_sbrk(size_t size) {
     return brk;
 }
 
+/**
+ * The number of segregated free lists. Size class i holds free blocks
+ * whose size lies in [2^(i + 4), 2^(i + 5)), and the last size class also
+ * holds every larger block.
+ */
+#define CLASS_COUNT 24
+
+/**
+ * The offset used to represent the end of a free list.
+ */
+#define NIL ((uint32_t) -1)
+
+/**
+ * The smallest block able to hold a header, footer and free-list links.
+ */
+#define MIN_BLOCK_SIZE (2 * sizeof(header_t) + 2 * sizeof(uint32_t))
+
+uint32_t free_lists_[CLASS_COUNT];
+
+static header_t* block_footer(header_t *header) {
+    return (header_t*)((size_t) header + header_get_size(header)) - 1;
+}
+
+static header_t* block_at(uint32_t offset) {
+    return (header_t*)((size_t) mem_heap_lo() + offset);
+}
+
+static uint32_t block_offset(header_t *header) {
+    return (size_t) header - (size_t) mem_heap_lo();
+}
+
+static uint32_t* block_next(header_t *header) {
+    return (uint32_t*)(header + 1);
+}
+
+static uint32_t* block_prev(header_t *header) {
+    return (uint32_t*)(header + 1) + 1;
+}
+
+/**
+ * Returns the size class of a block of the given size in bytes.
+ */
+static int size_class(size_t size) {
+    int c = 31 - __builtin_clz((uint32_t) size) - 4;
+    if (c < 0) return 0;
+    return c < CLASS_COUNT ? c: CLASS_COUNT - 1;
+}
+
+/**
+ * Inserts a free block at the head of the free list of its size class.
+ */
+static void free_list_insert(header_t *header) {
+    uint32_t *head = &free_lists_[size_class(header_get_size(header))];
+    uint32_t offset = block_offset(header);
+    *block_next(header) = *head;
+    *block_prev(header) = NIL;
+    if (*head != NIL) {
+        *block_prev(block_at(*head)) = offset;
+    }
+    *head = offset;
+}
+
+/**
+ * Unlinks a free block from the free list of its size class.
+ */
+static void free_list_remove(header_t *header) {
+    uint32_t next = *block_next(header);
+    uint32_t prev = *block_prev(header);
+    if (prev != NIL) {
+        *block_next(block_at(prev)) = next;
+    } else {
+        free_lists_[size_class(header_get_size(header))] = next;
+    }
+    if (next != NIL) {
+        *block_prev(block_at(next)) = prev;
+    }
+}
+
 int mem_init(void) {
     brk_ = (size_t)(__builtin_wasm_memory_size(0) * PAGE_SIZE);
+    for (int i = 0; i < CLASS_COUNT; i++) {
+        free_lists_[i] = NIL;
+    }
     header_t *header = (header_t *) mem_heap_lo();
     header_t *footer = ((header_t *) mem_heap_hi()) - 1;
     size_t block_size = (size_t) footer - (size_t) header + sizeof(header_t);
     header_set(header, 1, block_size);
     header_set(footer, 1, block_size);
+    free_list_insert(header);
     return 1;
 }
 
-
+/**
+ * Allocates the first `size` bytes of the given free block, which must
+ * already have been removed from its free list. If the remainder is large
+ * enough to form a block of its own, it is split off and returned to the
+ * free lists.
+ */
 void split(header_t *header, size_t size) {
     size_t capacity = header_get_size(header);
-    
-    if (capacity - size > 2 * sizeof(header_t)) {
+
+    if (capacity - size >= MIN_BLOCK_SIZE) {
         header_t *footer = (header_t*)((size_t) header + size) - 1;
         header_t *next_header = footer + 1;
         header_t *next_footer = (header_t*)((size_t) header + capacity) - 1;
@@ -85,6 +180,7 @@ void split(header_t *header, size_t size) {
         header_set(footer, 0, size);
         header_set(next_header, 1, capacity - size);
         header_set(next_footer, 1, capacity - size);
+        free_list_insert(next_header);
     } else {
         header_t *footer = (header_t*)((size_t) header + capacity) - 1;
         header_set_free(header, 0);
@@ -94,78 +190,129 @@ void split(header_t *header, size_t size) {
 
 void* malloc(size_t size) {
     size = (size + ALIGNMENT-1) & ~(ALIGNMENT-1);
-    header_t *current_header = (header_t *) mem_heap_lo();
-    while ((size_t) current_header < (size_t) mem_heap_hi()) {
-        int current_free = header_get_free(current_header);
-        int current_size = header_get_size(current_header);
-        header_t *current_footer = (header_t*)((size_t) current_header + current_size) - 1;
-        if (current_free && current_size > size + 2 * sizeof(header_t)) {
-            split(current_header, size + 2 * sizeof(header_t));
-            return current_header + 1;     
+    size_t block_size = size + 2 * sizeof(header_t);
+    if (block_size < MIN_BLOCK_SIZE) {
+        block_size = MIN_BLOCK_SIZE;
+    }
+
+    // Blocks in the size class of the request may be too small, so its list
+    // is searched first-fit. Every block in a larger class is large enough,
+    // so the head of the first non-empty larger class is taken directly.
+    int c = size_class(block_size);
+    for (uint32_t offset = free_lists_[c]; offset != NIL; offset = *block_next(block_at(offset))) {
+        header_t *header = block_at(offset);
+        if (header_get_size(header) >= block_size) {
+            free_list_remove(header);
+            split(header, block_size);
+            return header + 1;
         }
-        current_header = current_footer + 1;
     }
-    
-    header_t *header = (header_t *) mem_sbrk(2 * sizeof(header_t) + size);
+    for (c = c + 1; c < CLASS_COUNT; c++) {
+        if (free_lists_[c] != NIL) {
+            header_t *header = block_at(free_lists_[c]);
+            free_list_remove(header);
+            split(header, block_size);
+            return header + 1;
+        }
+    }
+
+    header_t *header = (header_t *) mem_sbrk(block_size);
     header_t *footer = (header_t *) mem_heap_hi() - 1;
-    size_t block_size = (size_t) footer - (size_t) header + sizeof(header_t);
     header_set(header, 0, block_size);
     header_set(footer, 0, block_size);
     return header + 1;
 }
 
+mem_stats_t mem_stats_;
+
+mem_stats_t* mem_stats(void) {
+    return &mem_stats_;
+}
+
+/**
+ * Resizes the allocation at `p` to hold at least `size` bytes. Growing an
+ * allocation is attempted in place before falling back to moving it: the
+ * block absorbs the following block if it is free and large enough, and a
+ * block at the top of the heap is extended by moving the break.
+ */
 void* realloc(void *p, size_t size) {
     size = (size + ALIGNMENT-1) & ~(ALIGNMENT-1);
 
-    if (p != NULL) {
-        header_t *header = (header_t*) p - 1;
-        size_t existing_block_size = header_get_size(header);
-        
-        size_t requested_block_size = size + 2 * sizeof(header_t);
-        if (requested_block_size <= existing_block_size) {
-            return p;
-        } else {
-            void *n = malloc(size);
-            memcpy(n, p, existing_block_size - 2 * sizeof(header_t));
-            free(p); 
-            return n;    
+    if (p == NULL) {
+        return malloc(size);
+    }
+
+    mem_stats_.realloc_count += 1;
+    header_t *header = (header_t*) p - 1;
+    size_t existing_block_size = header_get_size(header);
+    size_t requested_block_size = size + 2 * sizeof(header_t);
+    if (requested_block_size <= existing_block_size) {
+        mem_stats_.realloc_fit_count += 1;
+        return p;
+    }
+
+    // The following block is absorbed if it is free. If the combined block
+    // is still too small but ends at the break, the break is moved to make
+    // up the difference.
+    header_t *next_header = block_footer(header) + 1;
+    size_t available = existing_block_size;
+    if ((size_t) next_header < (size_t) mem_heap_hi() && header_get_free(next_header)) {
+        size_t next_size = header_get_size(next_header);
+        if (available + next_size >= requested_block_size || (size_t) next_header + next_size == (size_t) mem_heap_hi()) {
+            free_list_remove(next_header);
+            available += next_size;
+            next_header = (header_t*)((size_t) next_header + next_size);
+            mem_stats_.realloc_absorb_count += 1;
         }
-    } else {
-        void *ret = malloc(size);
-        return ret;
     }
+    if (available < requested_block_size && (size_t) next_header == (size_t) mem_heap_hi()) {
+        mem_sbrk(requested_block_size - available);
+        available = requested_block_size;
+        mem_stats_.realloc_extend_count += 1;
+    }
+    if (available >= requested_block_size) {
+        header_set(header, 0, available);
+        header_set(block_footer(header), 0, available);
+        split(header, requested_block_size);
+        return p;
+    }
+
+    void *n = malloc(size);
+    memcpy(n, p, existing_block_size - 2 * sizeof(header_t));
+    free(p);
+    mem_stats_.realloc_move_count += 1;
+    mem_stats_.realloc_bytes_copied += existing_block_size - 2 * sizeof(header_t);
+    return n;
 }
 
+/**
+ * Marks the given block as free, merges it with its neighbours if they are
+ * also free, and inserts the resulting block into the free lists.
+ */
 void coalesce(header_t *header) {
     size_t size = header_get_size(header);
-    header_t *footer = (header_t*)((size_t) header + size) - 1;
-
-    header_t *prev_footer = header - 1;
-    size_t prev_size = header_get_size(prev_footer);
-    int prev_free = header_get_free(prev_footer);
-    header_t *prev_header = (header_t*)((size_t) header - prev_size);
+    header_t *footer = block_footer(header);
 
-    if (prev_free) {
-        size += prev_size;
-        header = prev_header;
-        header_set_size(header, size);
-        header_set_size(footer, size);
+    if ((size_t) header > (size_t) mem_heap_lo()) {
+        header_t *prev_footer = header - 1;
+        size_t prev_size = header_get_size(prev_footer);
+        if (header_get_free(prev_footer)) {
+            header = (header_t*)((size_t) header - prev_size);
+            free_list_remove(header);
+            size += prev_size;
+        }
     }
 
     header_t *next_header = footer + 1;
-    size_t next_size = header_get_size(next_header);
-    int next_free = header_get_free(next_header);
-    header_t *next_footer = (header_t*)((size_t) next_header + next_size) - 1;
-
-    if (next_free) {
-        size += next_size;
-        footer = next_footer;
-        header_set_size(header, size);
-        header_set_size(footer, size);
+    if ((size_t) next_header < (size_t) mem_heap_hi() && header_get_free(next_header)) {
+        footer = block_footer(next_header);
+        free_list_remove(next_header);
+        size += header_get_size(next_header);
     }
 
-    header_set_free(header, 1);
-    header_set_free(footer, 1);
+    header_set(header, 1, size);
+    header_set(footer, 1, size);
+    free_list_insert(header);
 }
 
 void free(void *p) {
@@ -1,21 +1,127 @@
 #include "stdlib.hpp"
+#include <voxel/Browser.hpp>
 
+/*
+ * A 64 bit word which may be loaded from an address of any alignment.
+ * WebAssembly permits unaligned loads, so this is only a hint to the compiler
+ * that it must not assume the address is aligned.
+ */
+typedef uint64_t __attribute__((aligned(1))) unaligned_uint64_t;
+
+#define WORD_SIZE sizeof(uint64_t)
+
+/*
+ * When the target supports bulk memory operations, memcpy and memset are
+ * lowered by the compiler to single memory.copy and memory.fill instructions,
+ * which the engine implements natively. Otherwise the copy is performed a
+ * word at a time: the destination is brought into alignment byte by byte,
+ * whole words are copied, and the remaining tail is copied byte by byte.
+ */
 int memcpy(void *a, void *b, size_t n) {
-    uint8_t *ptr1 = (uint8_t*) a;
-    uint8_t *ptr2 = (uint8_t*) b;
-    for (size_t i = 0; i < n; i++) {
-        *(uint8_t*)(ptr1) = *(uint8_t*)(ptr2);
-        ptr1++;
-        ptr2++;
+#ifdef __wasm_bulk_memory__
+    __builtin_memcpy(a, b, n);
+#else
+    uint8_t *dst = (uint8_t*) a;
+    uint8_t *src = (uint8_t*) b;
+    while (n > 0 && ((size_t) dst & (WORD_SIZE - 1)) != 0) {
+        *dst++ = *src++;
+        n--;
+    }
+    while (n >= 4 * WORD_SIZE) {
+        uint64_t w0 = ((unaligned_uint64_t *) src)[0];
+        uint64_t w1 = ((unaligned_uint64_t *) src)[1];
+        uint64_t w2 = ((unaligned_uint64_t *) src)[2];
+        uint64_t w3 = ((unaligned_uint64_t *) src)[3];
+        ((uint64_t *) dst)[0] = w0;
+        ((uint64_t *) dst)[1] = w1;
+        ((uint64_t *) dst)[2] = w2;
+        ((uint64_t *) dst)[3] = w3;
+        dst += 4 * WORD_SIZE;
+        src += 4 * WORD_SIZE;
+        n -= 4 * WORD_SIZE;
+    }
+    while (n >= WORD_SIZE) {
+        *(uint64_t *) dst = *(unaligned_uint64_t *) src;
+        dst += WORD_SIZE;
+        src += WORD_SIZE;
+        n -= WORD_SIZE;
+    }
+    while (n > 0) {
+        *dst++ = *src++;
+        n--;
     }
+#endif
     return 0;
 }
 
 int memset(void *a, char b, size_t n) {
-    uint8_t *ptr1 = (uint8_t*) a;
-    for (size_t i = 0; i < n; i++) {
-        *(ptr1) = b;
-        ptr1++;
+#ifdef __wasm_bulk_memory__
+    __builtin_memset(a, b, n);
+#else
+    uint8_t *dst = (uint8_t*) a;
+    while (n > 0 && ((size_t) dst & (WORD_SIZE - 1)) != 0) {
+        *dst++ = b;
+        n--;
     }
+    uint64_t word = (uint8_t) b * 0x0101010101010101ull;
+    while (n >= 4 * WORD_SIZE) {
+        ((uint64_t *) dst)[0] = word;
+        ((uint64_t *) dst)[1] = word;
+        ((uint64_t *) dst)[2] = word;
+        ((uint64_t *) dst)[3] = word;
+        dst += 4 * WORD_SIZE;
+        n -= 4 * WORD_SIZE;
+    }
+    while (n >= WORD_SIZE) {
+        *(uint64_t *) dst = word;
+        dst += WORD_SIZE;
+        n -= WORD_SIZE;
+    }
+    while (n > 0) {
+        *dst++ = b;
+        n--;
+    }
+#endif
     return 0;
 }
+
+/*
+ * The size of the buffer copied by memory_benchmark: the vertex positions of
+ * a dense chunk mesh of 65536 vertices.
+ */
+#define BENCHMARK_BUFFER_SIZE (65536 * 3 * sizeof(float))
+
+void memory_benchmark(int iterations) {
+    uint8_t *src = (uint8_t *) malloc(BENCHMARK_BUFFER_SIZE + 1);
+    uint8_t *dst = (uint8_t *) malloc(BENCHMARK_BUFFER_SIZE + 1);
+    memset(src, 7, BENCHMARK_BUFFER_SIZE + 1);
+
+    // The destination is accessed through a volatile pointer so that the
+    // compiler does not replace the loop with a call to memcpy.
+    double start = now();
+    for (int n = 0; n < iterations; n++) {
+        volatile uint8_t *d = dst;
+        for (size_t i = 0; i < BENCHMARK_BUFFER_SIZE; i++) {
+            d[i] = src[i];
+        }
+    }
+    double bytewise_time = now() - start;
+
+    start = now();
+    for (int n = 0; n < iterations; n++) {
+        memcpy(dst, src, BENCHMARK_BUFFER_SIZE);
+    }
+    double aligned_time = now() - start;
+
+    start = now();
+    for (int n = 0; n < iterations; n++) {
+        memcpy(dst, src + 1, BENCHMARK_BUFFER_SIZE);
+    }
+    double unaligned_time = now() - start;
+
+    free(src);
+    free(dst);
+    print_float(bytewise_time);
+    print_float(aligned_time);
+    print_float(unaligned_time);
+}
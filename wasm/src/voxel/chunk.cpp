@@ -2,6 +2,7 @@
 #include <voxel/world.hpp>
 #include <voxel/Chunk.hpp>
 #include <voxel/cube.hpp>
+#include <voxel/Perlin.hpp>
 
 #define TRUE 1
 #define FALSE 0
@@ -10,6 +11,145 @@ float max(float a, float b) {
     return a > b ? a: b;
 }
 
+/*
+ * Returns the number of bits needed to index a palette of the given size.
+ * Sizes which do not fit in a BlockStorage palette use 8 bit direct storage.
+ */
+static int palette_bits(int size) {
+    if (size <= 1) return 0;
+    if (size <= 2) return 1;
+    if (size <= 4) return 2;
+    if (size <= BlockStorage::PALETTE_CAPACITY) return 4;
+    return 8;
+}
+
+/*
+ * Converts the packed data to the given number of bits per block. Converting
+ * to 8 bits replaces palette indices with the block values themselves.
+ */
+void BlockStorage::repack(int bits) {
+    uint8_t *data = nullptr;
+    if (bits > 0) {
+        data = (uint8_t *) malloc(VOLUME * bits / 8);
+        memset(data, 0, VOLUME * bits / 8);
+        for (int i = 0; i < VOLUME; i++) {
+            int value = bits_ == 0 ? 0: readPacked(data_, bits_, i);
+            if (bits == 8 && bits_ != 8) {
+                value = (int) palette_[value];
+            }
+            writePacked(data, bits, i, value);
+        }
+    }
+    free(data_);
+    data_ = data;
+    bits_ = bits;
+}
+
+void BlockStorage::set(int x, int y, int z, Block b) {
+    int i = index(x, y, z);
+    if (bits_ == 8) {
+        writePacked(data_, bits_, i, (int) b);
+        return;
+    }
+
+    int p = 0;
+    while (p < palette_size_ && palette_[p] != b) {
+        p++;
+    }
+
+    if (p == palette_size_) {
+        if (palette_size_ == PALETTE_CAPACITY) {
+            repack(8);
+            writePacked(data_, bits_, i, (int) b);
+            return;
+        }
+        palette_[palette_size_] = b;
+        palette_size_ += 1;
+        if (palette_bits(palette_size_) != bits_) {
+            repack(palette_bits(palette_size_));
+        }
+    }
+
+    if (bits_ > 0) {
+        writePacked(data_, bits_, i, p);
+    }
+}
+
+void BlockStorage::compact() {
+    if (bits_ == 0) return;
+
+    int remap[256];
+    for (int v = 0; v < 256; v++) {
+        remap[v] = -1;
+    }
+
+    Block palette[PALETTE_CAPACITY];
+    int size = 0;
+    for (int i = 0; i < VOLUME; i++) {
+        int value = readPacked(data_, bits_, i);
+        if (remap[value] < 0) {
+            if (size == PALETTE_CAPACITY) return;
+            remap[value] = size;
+            palette[size] = bits_ == 8 ? Block{(Block::Value) value}: palette_[value];
+            size += 1;
+        }
+    }
+
+    int bits = palette_bits(size);
+    if (bits == bits_ && size == palette_size_) return;
+
+    uint8_t *data = nullptr;
+    if (bits > 0) {
+        data = (uint8_t *) malloc(VOLUME * bits / 8);
+        memset(data, 0, VOLUME * bits / 8);
+        for (int i = 0; i < VOLUME; i++) {
+            writePacked(data, bits, i, remap[readPacked(data_, bits_, i)]);
+        }
+    }
+    free(data_);
+    data_ = data;
+    bits_ = bits;
+    palette_size_ = size;
+    for (int p = 0; p < size; p++) {
+        palette_[p] = palette[p];
+    }
+}
+
+void BlockStorage::save(voxel::ArrayList<uint8_t> &out) const {
+    out.append(bits_);
+    out.append(palette_size_);
+    for (int p = 0; p < palette_size_; p++) {
+        out.append((int) palette_[p]);
+    }
+    for (unsigned int i = 0; i < byteCount(); i++) {
+        out.append(data_[i]);
+    }
+}
+
+int BlockStorage::load(const uint8_t *data, unsigned int length) {
+    if (length < 2) return -1;
+    int bits = data[0];
+    int palette_size = data[1];
+    if (palette_size < 1 || palette_size > PALETTE_CAPACITY) return -1;
+    if (bits != 8 && bits != palette_bits(palette_size)) return -1;
+
+    unsigned int size = VOLUME * bits / 8;
+    if (length < 2 + palette_size + size) return -1;
+
+    free(data_);
+    data_ = nullptr;
+    if (size > 0) {
+        data_ = (uint8_t *) malloc(size);
+        memcpy(data_, (void *) (data + 2 + palette_size), size);
+    }
+    bits_ = bits;
+    palette_size_ = palette_size;
+    for (int p = 0; p < palette_size; p++) {
+        palette_[p] = (Block::Value) data[2 + p];
+    }
+    return 2 + palette_size + size;
+}
+
 /*
  * Initializes a chunk with a simple flat world. This function quite simply fills
  * the bottom 99 blocks with stone, the 100th block with glass, and the rest with 
@@ -20,36 +160,35 @@ Chunk::Chunk(struct World *w, int x, int z, uint32_t seed) {
     world = w;
     chunk_x = x;
     chunk_z = z;
-    update_ = TRUE;
+    saved_ = FALSE;
+    invalidate();
+    computeHeightmap();
 
     for (int i = 0; i < CHUNK_SIZE; i++) {
-        for (int j = 0; j < CHUNK_HEIGHT; j++) {
-            for (int k = 0; k < CHUNK_SIZE; k++) {
-                float block_x = i + x * CHUNK_SIZE;
-                float block_y = j;
-                float block_z = k + z * CHUNK_SIZE;
-                int top = World::elevation(block_x, block_z);
+        for (int k = 0; k < CHUNK_SIZE; k++) {
+            int top = heightmap_[i][k];
+            for (int j = 0; j < CHUNK_HEIGHT; j++) {
                 if (j < top - 10) {
-                    blocks[i][j][k] = Block::Stone;
+                    storeBlock(i, j, k, Block::Stone);
                 } else if (j < top - 1) {
-                    blocks[i][j][k] = Block::Dirt;
+                    storeBlock(i, j, k, Block::Dirt);
                 } else if (j < top) {
-                    blocks[i][j][k] = Block::Grass;
+                    storeBlock(i, j, k, Block::Grass);
                 } else if (j < World::sea_level()) {
-                    blocks[i][j][k] = Block::Water;
+                    storeBlock(i, j, k, Block::Water);
                 } else {
-                    blocks[i][j][k] = Block::Air;
+                    storeBlock(i, j, k, Block::Air);
                 }
             }
         }
     }
 
+    // Trees extend two blocks in each direction from their trunk, so trunks
+    // are placed at least two blocks from the edge of the chunk.
     for (int t = 0; t < 2; t++) {
-        int tx = (int)(14 * random() + 2);
-        int tz = (int)(14 * random() + 2);
-        float tree_x = tx + x * CHUNK_SIZE;
-        float tree_z = tz + z * CHUNK_SIZE;
-        int tree_y = World::elevation(tree_x, tree_z);
+        int tx = (int)(12 * random() + 2);
+        int tz = (int)(12 * random() + 2);
+        int tree_y = heightmap_[tx][tz];
         if (tree_y <= World::sea_level()) {
             continue;
         }
@@ -57,42 +196,133 @@ Chunk::Chunk(struct World *w, int x, int z, uint32_t seed) {
             for (int j = 0; j < 10; j++) {
                 for (int k = -2; k <= 2; k++) {
                     if (i == 0 && k == 0  && j < 6) {
-                        blocks[tx + i][tree_y + j][tz + k] = Block::Wood;
+                        storeBlock(tx + i, tree_y + j, tz + k, Block::Wood);
                     } else if (i * i + k * k + (j-6) * (j-6) < 8) {
-                        blocks[tx + i][tree_y + j][tz + k] = Block::Leaves;
+                        storeBlock(tx + i, tree_y + j, tz + k, Block::Leaves);
                     }
                 }
             }
         }
     }
+}
 
+Chunk::Chunk(struct World *w, int x, int z) {
+    world = w;
+    chunk_x = x;
+    chunk_z = z;
+    saved_ = FALSE;
+    invalidate();
+}
 
+/*
+ * Evaluates the terrain elevation once for each column of the chunk. Terrain
+ * generation and tree placement read the cached heights rather than
+ * evaluating the noise function for every block. The noise for the whole
+ * chunk is generated in a single batch, which is considerably faster than
+ * evaluating it one column at a time.
+ */
+void Chunk::computeHeightmap() {
+    float noise[CHUNK_SIZE * CHUNK_SIZE];
+    perlin2d_grid(noise, chunk_x * CHUNK_SIZE, chunk_z * CHUNK_SIZE, CHUNK_SIZE, CHUNK_SIZE, TERRAIN_FREQUENCY, TERRAIN_OCTAVES);
+    for (int i = 0; i < CHUNK_SIZE; i++) {
+        for (int k = 0; k < CHUNK_SIZE; k++) {
+            heightmap_[i][k] = World::elevation(noise[k * CHUNK_SIZE + i]);
+        }
+    }
+}
+
+/*
+ * Sets the height of the column (x, z) to one above its top solid block at
+ * or below y. A column filled to the top of the chunk is clamped to the
+ * largest height which fits in the heightmap.
+ */
+void Chunk::scanColumn(int x, int z, int y) {
+    while (y >= 0 && !getBlock(x, y, z).solid()) {
+        y--;
+    }
+    heightmap_[x][z] = y + 1 < CHUNK_HEIGHT ? y + 1: CHUNK_HEIGHT - 1;
+}
+
+/*
+ * Finds the top solid block of each column of the chunk. This is used for
+ * chunks loaded from region files, whose blocks may have been edited since
+ * the terrain was generated.
+ */
+void Chunk::scanHeightmap() {
+    for (int i = 0; i < CHUNK_SIZE; i++) {
+        for (int k = 0; k < CHUNK_SIZE; k++) {
+            scanColumn(i, k, CHUNK_HEIGHT - 1);
+        }
+    }
+}
+
+void Chunk::save(voxel::ArrayList<uint8_t> &out) {
+    for (int s = 0; s < SECTION_COUNT; s++) {
+        sections_[s].blocks.save(out);
+    }
+    saved_ = TRUE;
+}
+
+bool Chunk::load(const uint8_t *data, unsigned int length) {
+    unsigned int offset = 0;
+    for (int s = 0; s < SECTION_COUNT; s++) {
+        int read = sections_[s].blocks.load(data + offset, length - offset);
+        if (read < 0) {
+            return false;
+        }
+        offset += read;
+    }
+    scanHeightmap();
+    saved_ = TRUE;
+    invalidate();
+    return true;
 }
 
 /*
  * Sets the block at position (x, y, z) in the chunk to b. 
- * This has the additional side effect of marking 'update'
- * as true.
+ * This has the additional side effect of marking the section containing the
+ * block for an update, along with any section in this chunk or a neighbouring
+ * chunk which shares a face with the block.
  */
 Block Chunk::setBlock(int x, int y, int z, Block b) {
-    update_ = TRUE;
+    saved_ = FALSE;
+    int section = y / SECTION_HEIGHT;
+    invalidate(section);
+    if (y % SECTION_HEIGHT == 0 && section > 0) {
+        invalidate(section - 1);
+    } else if (y % SECTION_HEIGHT == SECTION_HEIGHT - 1 && section < SECTION_COUNT - 1) {
+        invalidate(section + 1);
+    }
+
     if (x == 0) {
         Chunk *l = world_get_chunk(world, chunk_x - 1, chunk_z);
-        l->update_ = TRUE;
-
+        if (l != NULL) l->invalidate(section);
     } else if (x == CHUNK_SIZE - 1) {
         Chunk *l = world_get_chunk(world, chunk_x + 1, chunk_z);
-        l->update_ = TRUE;
+        if (l != NULL) l->invalidate(section);
     }
 
     if (z == 0) {
         Chunk *l = world_get_chunk(world, chunk_x, chunk_z - 1);
-        l->update_ = TRUE;
+        if (l != NULL) l->invalidate(section);
     } else if (z == CHUNK_SIZE - 1) {
         Chunk *l = world_get_chunk(world, chunk_x, chunk_z + 1);
-        l->update_ = TRUE;
+        if (l != NULL) l->invalidate(section);
+    }
+    storeBlock(x, y, z, b);
+
+    // Keep the surface height of the column current: a solid block placed
+    // above the surface raises it, and removing the top block lowers it to
+    // the next solid block below. A clamped height does not tell whether the
+    // top block is at the top of the chunk, so such a column is rescanned
+    // from the top.
+    int height = heightmap_[x][z];
+    if (b.solid() && y >= height) {
+        heightmap_[x][z] = y + 1 < CHUNK_HEIGHT ? y + 1: CHUNK_HEIGHT - 1;
+    } else if (!b.solid() && y >= height - 1) {
+        scanColumn(x, z, height == CHUNK_HEIGHT - 1 ? CHUNK_HEIGHT - 1: y - 1);
     }
-    return blocks[x][y][z] = b;
+    return b;
 }
 
 int is_block_transparent(Block block, Block b) {
@@ -108,11 +338,12 @@ int is_block_transparent(Block block, Block b) {
 }
 
 int Chunk::isBlockVisible(int x, int y, int z) {
-    
+    Block block = getBlock(x, y, z);
+
     /*
      * Air blocks are never visible, so we return FALSE in all cases.
      */
-    if (blocks[x][y][z] == Block::Air) return Face::None;
+    if (block == Block::Air) return Face::None;
 
     int face = Face::None;
 
@@ -120,12 +351,12 @@ int Chunk::isBlockVisible(int x, int y, int z) {
      * If any of the adjacent blocks in the blocks own chunk are air, then it
      * is possible for the block to be visible.
      */
-    if (y != 0 && is_block_transparent(blocks[x][y - 1][z], blocks[x][y][z])) face |= Face::Bottom;
-    if (y != CHUNK_HEIGHT - 1 && is_block_transparent(blocks[x][y + 1][z], blocks[x][y][z])) face |= Face::Top;
-    if (x != 0 && is_block_transparent(blocks[x - 1][y][z], blocks[x][y][z])) face |= Face::Left;
-    if (x != CHUNK_SIZE - 1 && is_block_transparent(blocks[x + 1][y][z], blocks[x][y][z])) face |= Face::Right;
-    if (z != 0 && is_block_transparent(blocks[x][y][z - 1], blocks[x][y][z])) face |= Face::Back;
-    if (z != CHUNK_SIZE - 1 && is_block_transparent(blocks[x][y][z + 1], blocks[x][y][z])) face |= Face::Front;
+    if (y != 0 && is_block_transparent(getBlock(x, y - 1, z), block)) face |= Face::Bottom;
+    if (y != CHUNK_HEIGHT - 1 && is_block_transparent(getBlock(x, y + 1, z), block)) face |= Face::Top;
+    if (x != 0 && is_block_transparent(getBlock(x - 1, y, z), block)) face |= Face::Left;
+    if (x != CHUNK_SIZE - 1 && is_block_transparent(getBlock(x + 1, y, z), block)) face |= Face::Right;
+    if (z != 0 && is_block_transparent(getBlock(x, y, z - 1), block)) face |= Face::Back;
+    if (z != CHUNK_SIZE - 1 && is_block_transparent(getBlock(x, y, z + 1), block)) face |= Face::Front;
 
     /*
      * If there is an air block block on another chunk adjacent to our block,
@@ -141,183 +372,369 @@ int Chunk::isBlockVisible(int x, int y, int z) {
 
     if (x == 0) {
         Chunk *l = world_get_chunk(world, chunk_x - 1, chunk_z);
-        if (l != NULL && is_block_transparent(l->blocks[CHUNK_SIZE - 1][y][z], blocks[x][y][z])) {
+        if (l != NULL && is_block_transparent(l->getBlock(CHUNK_SIZE - 1, y, z), block)) {
             face |= Face::Left;
         }
     } else if (x == CHUNK_SIZE - 1) {
         Chunk *r = world_get_chunk(world, chunk_x + 1, chunk_z);
-        if (r != NULL && is_block_transparent(r->blocks[0][y][z], blocks[x][y][z])) {
+        if (r != NULL && is_block_transparent(r->getBlock(0, y, z), block)) {
             face |= Face::Right;
         }
     }
 
     if (z == 0) {
         Chunk *t = world_get_chunk(world, chunk_x, chunk_z - 1);
-        if (t != NULL && is_block_transparent(t->blocks[x][y][CHUNK_SIZE - 1], blocks[x][y][z])) {
+        if (t != NULL && is_block_transparent(t->getBlock(x, y, CHUNK_SIZE - 1), block)) {
             face |= Face::Back;
         }
     } else if (z == CHUNK_SIZE - 1) {
         Chunk *b = world_get_chunk(world, chunk_x, chunk_z + 1);
-        if (b != NULL && is_block_transparent(b->blocks[x][y][0], blocks[x][y][z])) {
+        if (b != NULL && is_block_transparent(b->getBlock(x, y, 0), block)) {
             face |= Face::Front;
         }
     }
     return face; 
 }
 
-void Chunk::computeMesh() {
-    int block_i = 0;
+const int face_directions[FACE_COUNT][3] = {
+    {0, 0, 1}, {0, 0, -1}, {0, 1, 0}, {0, -1, 0}, {1, 0, 0}, {-1, 0, 0},
+};
+
+MeshMode Chunk::mesh_mode = MeshMode::Naive;
+
+voxel::Arena chunk_mesh_arena;
 
-    opaque_mesh.clear();
+/*
+ * Builds the meshes of a section in the scratch arena, uploads them, and
+ * then releases the scratch memory in a single reset. A rebuild usually
+ * produces a mesh of similar size to the previous one, so the previous
+ * counts are used to preallocate the mesh data.
+ */
+void Chunk::computeMesh(int section) {
+    voxel::Mesh &opaque_mesh = sections_[section].opaque_mesh;
+    voxel::Mesh &transparent_mesh = sections_[section].transparent_mesh;
+    {
+        ChunkMeshData opaque;
+        ChunkMeshData transparent;
+        opaque.reserve(opaque_mesh.vertexCount(), opaque_mesh.faceCount());
+        transparent.reserve(transparent_mesh.vertexCount(), transparent_mesh.faceCount());
+        if (mesh_mode == MeshMode::Greedy) {
+            computeGreedyMesh(section, opaque, transparent);
+        } else {
+            computeNaiveMesh(section, opaque, transparent);
+        }
+        int x = chunk_x * CHUNK_SIZE;
+        int y = section * SECTION_HEIGHT;
+        int z = chunk_z * CHUNK_SIZE;
+        opaque_mesh.update(opaque, x, y, z);
+        transparent_mesh.update(transparent, x, y, z);
+    }
+    chunk_mesh_arena.reset();
+}
 
+/*
+ * Appends the visible faces of a single block to the given mesh. Only the
+ * four vertices of each exposed face are emitted, so a block with a single
+ * visible face contributes 4 vertices rather than all 24 of the cube. The
+ * block coordinates are relative to the origin of the section.
+ */
+static void append_naive_block(ChunkMeshData &mesh, Block block, uint8_t visible, int block_x, int block_y, int block_z) {
+    for (int i = 0; i < 6; i++) {
+        Face face = (Face) (1 << i);
+        if (!(visible & face)) {
+            continue;
+        }
+        voxel::Array<float, 2> tile = block.textureIndex(face);
+        unsigned int base = mesh.vertices.size();
+        for (int v = 4 * i; v < 4 * i + 4; v++) {
+            mesh.appendVertex({
+                (uint8_t) (block_x + (single_positions[v][0] > 0)),
+                (uint8_t) (block_y + (single_positions[v][1] > 0)),
+                (uint8_t) (block_z + (single_positions[v][2] > 0)),
+                (uint8_t) i,
+                (uint8_t) tile[0],
+                (uint8_t) tile[1],
+                (uint8_t) single_texture_coords[v][0],
+                (uint8_t) single_texture_coords[v][1]
+            });
+        }
+        mesh.appendFace({
+            single_indices[6 * i] - 4 * i + base,
+            single_indices[6 * i + 1] - 4 * i + base,
+            single_indices[6 * i + 2] - 4 * i + base,
+        });
+        mesh.appendFace({
+            single_indices[6 * i + 3] - 4 * i + base,
+            single_indices[6 * i + 4] - 4 * i + base,
+            single_indices[6 * i + 5] - 4 * i + base,
+        });
+    }
+}
+
+void Chunk::computeNaiveMesh(int section, ChunkMeshData &opaque_mesh, ChunkMeshData &transparent_mesh) {
+    int y0 = section * SECTION_HEIGHT;
     for (int x = 0; x < CHUNK_SIZE; x++) {
-        for (int y = 0; y < CHUNK_HEIGHT; y++) {
+        for (int y = y0; y < y0 + SECTION_HEIGHT; y++) {
             for (int z = 0; z < CHUNK_SIZE; z++) {
-                if (is_block_transparent(blocks[x][y][z], Block::Air)) {
+                Block block = getBlock(x, y, z);
+                if (block == Block::Air) {
                     continue;
                 }
                 uint8_t visible = isBlockVisible(x, y, z);
                 if (visible) {
-
-                    float block_x = x + chunk_x * CHUNK_SIZE;
-                    float block_y = y;
-                    float block_z = z + chunk_z * CHUNK_SIZE;
-
-                    Block block = blocks[x][y][z];
-
-                    for (int v = 0; v < 24; v++) {
-                        Face face = (Face) (1 << (v / 4));
-                        opaque_mesh.appendVertex({
-                            single_positions[v][0] + 2 * block_x,
-                            single_positions[v][1] + 2 * block_y,
-                            single_positions[v][2] + 2 * block_z
-                        });
-                        opaque_mesh.appendTextureCoord({
-                            (single_texture_coords[v][0] + block.textureIndex(face)[0]) / 16.0,
-                            (single_texture_coords[v][1] + block.textureIndex(face)[1]) / 16.0
-                        });
-                        opaque_mesh.appendNormal({
-                            single_normals[v][0],
-                            single_normals[v][1],
-                            single_normals[v][2]
-                        });
-                    }
-                    for (int i = 0; i < 6; i++) {
-                        int face = 1 << i;
-                        if (visible & face) {
-                            opaque_mesh.appendFace({
-                                single_indices[6 * i] + block_i * 24,
-                                single_indices[6 * i + 1] + block_i * 24,
-                                single_indices[6 * i + 2] + block_i * 24,
-                            });
-                            opaque_mesh.appendFace({
-                                single_indices[6 * i + 3] + block_i * 24,
-                                single_indices[6 * i + 4] + block_i * 24,
-                                single_indices[6 * i + 5] + block_i * 24,
-                            });
-                        }
+                    if (is_block_transparent(block, Block::Air)) {
+                        append_naive_block(transparent_mesh, block, visible, x, y - y0, z);
+                    } else {
+                        append_naive_block(opaque_mesh, block, visible, x, y - y0, z);
                     }
-                    block_i += 1;
                 }
             }
         }
     }
-    
-    block_i = 0;
-    opaque_mesh.update();
-    transparent_mesh.clear();
+}
+
+/*
+ * The dimensions of a chunk section along the x, y, and z axes.
+ */
+static const int section_dimensions[3] = {CHUNK_SIZE, SECTION_HEIGHT, CHUNK_SIZE};
+
+/*
+ * The axis normal to each face, in the order defined by Face.
+ */
+static const int face_normal_axis[6] = {2, 2, 1, 1, 0, 0};
+
+/*
+ * The axes along which the u and v texture coordinates of each face increase,
+ * in the order defined by Face. These are derived from single_positions and
+ * single_texture_coords.
+ */
+static const int face_texture_axes[6][2] = {
+    {0, 1}, {0, 1}, {0, 2}, {2, 0}, {2, 1}, {2, 1}
+};
 
+/*
+ * Scratch buffers shared by all greedy mesh builds. The visibility buffer
+ * caches the result of isBlockVisible for every block of the section so that
+ * it is computed once per block rather than once per face. The mask buffer
+ * holds the block type of each visible face in the current slice.
+ */
+static uint8_t greedy_visibility[CHUNK_SIZE][SECTION_HEIGHT][CHUNK_SIZE];
+static uint8_t greedy_mask[CHUNK_SIZE * CHUNK_SIZE];
+
+/*
+ * Appends a quad covering the given face of the box of blocks starting at
+ * `origin`, relative to the origin of the section, with `size` blocks along
+ * each axis. Texture coordinates are scaled by the size of the quad so that
+ * the atlas tile repeats once per block.
+ */
+static void append_greedy_quad(ChunkMeshData &mesh, Block block, int f, const int origin[3], const int size[3]) {
+    Face face = (Face) (1 << f);
+    int u_axis = face_texture_axes[f][0];
+    int v_axis = face_texture_axes[f][1];
+    voxel::Array<float, 2> tile = block.textureIndex(face);
+    unsigned int base = mesh.vertices.size();
+
+    for (int v = 4 * f; v < 4 * f + 4; v++) {
+        uint8_t corner[3];
+        for (int a = 0; a < 3; a++) {
+            corner[a] = single_positions[v][a] < 0 ? origin[a]: origin[a] + size[a];
+        }
+        mesh.appendVertex({
+            corner[0],
+            corner[1],
+            corner[2],
+            (uint8_t) f,
+            (uint8_t) tile[0],
+            (uint8_t) tile[1],
+            (uint8_t) (single_texture_coords[v][0] * size[u_axis]),
+            (uint8_t) (single_texture_coords[v][1] * size[v_axis])
+        });
+    }
+    for (int i = 0; i < 6; i += 3) {
+        mesh.appendFace({
+            single_indices[6 * f + i] - 4 * f + base,
+            single_indices[6 * f + i + 1] - 4 * f + base,
+            single_indices[6 * f + i + 2] - 4 * f + base,
+        });
+    }
+}
+
+/*
+ * Builds the chunk mesh by merging faces. For each of the six face directions,
+ * the chunk is swept one slice at a time along the face normal. Visible faces
+ * in a slice are recorded in a two dimensional mask by block type, and the
+ * mask is then covered greedily with rectangles: each rectangle is extended
+ * as far as possible along u, then along v while every row matches. Since the
+ * texture of a face depends only on the block type and face direction, faces
+ * merged this way always share an atlas tile.
+ */
+void Chunk::computeGreedyMesh(int section, ChunkMeshData &opaque_mesh, ChunkMeshData &transparent_mesh) {
+    int y0 = section * SECTION_HEIGHT;
     for (int x = 0; x < CHUNK_SIZE; x++) {
-        for (int y = 0; y < CHUNK_HEIGHT; y++) {
+        for (int y = 0; y < SECTION_HEIGHT; y++) {
             for (int z = 0; z < CHUNK_SIZE; z++) {
-                if (!is_block_transparent(blocks[x][y][z], Block::Air)) {
-                    continue;
+                greedy_visibility[x][y][z] = isBlockVisible(x, y0 + y, z);
+            }
+        }
+    }
+
+    for (int f = 0; f < 6; f++) {
+        int face = 1 << f;
+        int n_axis = face_normal_axis[f];
+        int u_axis = face_texture_axes[f][0];
+        int v_axis = face_texture_axes[f][1];
+        int n_size = section_dimensions[n_axis];
+        int u_size = section_dimensions[u_axis];
+        int v_size = section_dimensions[v_axis];
+
+        for (int n = 0; n < n_size; n++) {
+            int p[3];
+            p[n_axis] = n;
+            for (int v = 0; v < v_size; v++) {
+                p[v_axis] = v;
+                for (int u = 0; u < u_size; u++) {
+                    p[u_axis] = u;
+                    uint8_t visible = greedy_visibility[p[0]][p[1]][p[2]];
+                    greedy_mask[v * u_size + u] = (visible & face) ? (int) getBlock(p[0], y0 + p[1], p[2]): 0;
                 }
-                uint8_t visible = isBlockVisible(x, y, z);
-                if (visible) {
+            }
+
+            for (int v = 0; v < v_size; v++) {
+                for (int u = 0; u < u_size;) {
+                    uint8_t value = greedy_mask[v * u_size + u];
+                    if (value == 0) {
+                        u++;
+                        continue;
+                    }
 
-                    float block_x = x + chunk_x * CHUNK_SIZE;
-                    float block_y = y;
-                    float block_z = z + chunk_z * CHUNK_SIZE;
-
-                    Block block = blocks[x][y][z];
-
-                    for (int v = 0; v < 24; v++) {
-                        Face face = (Face) (1 << (v / 4));
-
-                        transparent_mesh.appendVertex({
-                            single_positions[v][0] + 2 * block_x,
-                            single_positions[v][1] + 2 * block_y,
-                            single_positions[v][2] + 2 * block_z
-                        });
-                        transparent_mesh.appendTextureCoord({
-                            (single_texture_coords[v][0] + block.textureIndex(face)[0]) / 16.0,
-                            (single_texture_coords[v][1] + block.textureIndex(face)[1]) / 16.0
-                        });
-                        transparent_mesh.appendNormal({
-                            single_normals[v][0],
-                            single_normals[v][1],
-                            single_normals[v][2]
-                        });
+                    int width = 1;
+                    while (u + width < u_size && greedy_mask[v * u_size + u + width] == value) {
+                        width++;
                     }
-                    for (int i = 0; i < 6; i++) {
-                        int face = 1 << i;
-                        if (visible & face) {
-                            transparent_mesh.appendFace({
-                                single_indices[6 * i] + block_i * 24,
-                                single_indices[6 * i + 1] + block_i * 24,
-                                single_indices[6 * i + 2] + block_i * 24,
-                            });
-                            transparent_mesh.appendFace({
-                                single_indices[6 * i + 3] + block_i * 24,
-                                single_indices[6 * i + 4] + block_i * 24,
-                                single_indices[6 * i + 5] + block_i * 24,
-                            });
+
+                    int height = 1;
+                    while (v + height < v_size) {
+                        int k = 0;
+                        while (k < width && greedy_mask[(v + height) * u_size + u + k] == value) {
+                            k++;
                         }
+                        if (k < width) break;
+                        height++;
+                    }
+
+                    for (int j = 0; j < height; j++) {
+                        for (int k = 0; k < width; k++) {
+                            greedy_mask[(v + j) * u_size + u + k] = 0;
+                        }
+                    }
+
+                    int origin[3];
+                    int size[3];
+                    origin[n_axis] = n;
+                    origin[u_axis] = u;
+                    origin[v_axis] = v;
+                    size[n_axis] = 1;
+                    size[u_axis] = width;
+                    size[v_axis] = height;
+
+                    Block block = (Block::Value) value;
+                    if (is_block_transparent(block, Block::Air)) {
+                        append_greedy_quad(transparent_mesh, block, f, origin, size);
+                    } else {
+                        append_greedy_quad(opaque_mesh, block, f, origin, size);
                     }
-                    block_i += 1;
+                    u += width;
                 }
             }
         }
     }
-    transparent_mesh.update();
-
 }
 
-void Chunk::computePhysicsObjects() {
-    physics_objects_.clear();
-    size_t i = 0;
+/*
+ * Computes which faces of the given section can see each other. The
+ * transparent blocks of the section are partitioned into connected regions
+ * by a flood fill, and the faces touched by each region are all connected to
+ * one another. A player looking through the section from one face can only
+ * see out of the faces connected to it.
+ */
+void Chunk::computeConnectivity(int section) {
+    ChunkSection &s = sections_[section];
+    if (s.blocks.uniform()) {
+        uint8_t faces = is_block_transparent(s.blocks.get(0, 0, 0), Block::Air) ? ALL_FACES: 0;
+        for (int f = 0; f < FACE_COUNT; f++) {
+            s.connectivity[f] = faces;
+        }
+        return;
+    }
+
+    // Blocks are indexed by (x * SECTION_HEIGHT + y) * CHUNK_SIZE + z. A block
+    // is open if it is transparent and has not yet been visited.
+    static bool open[BlockStorage::VOLUME];
+    static uint16_t stack[BlockStorage::VOLUME];
     for (int x = 0; x < CHUNK_SIZE; x++) {
-        for (int y = 0; y < CHUNK_HEIGHT; y++) {
+        for (int y = 0; y < SECTION_HEIGHT; y++) {
             for (int z = 0; z < CHUNK_SIZE; z++) {
-                uint8_t visible = isBlockVisible(x, y, z);
-                if (visible && blocks[x][y][z] != Block::Water) {
-                    aabb3_t obj;
-                    float block_x = x + chunk_x * CHUNK_SIZE;
-                    float block_y = y;
-                    float block_z = z + chunk_z * CHUNK_SIZE;
-                    vec3_init(&obj.position, block_x * 2, block_y * 2, block_z * 2);
-                    vec3_init(&obj.size, 1, 1, 1);
-                    physics_objects_.append(obj);
-                    i += 1;
+                open[(x * SECTION_HEIGHT + y) * CHUNK_SIZE + z] = is_block_transparent(s.blocks.get(x, y, z), Block::Air);
+            }
+        }
+    }
+
+    for (int f = 0; f < FACE_COUNT; f++) {
+        s.connectivity[f] = 0;
+    }
+    for (int i = 0; i < BlockStorage::VOLUME; i++) {
+        if (!open[i]) continue;
+        int faces = 0;
+        int top = 0;
+        stack[top++] = i;
+        open[i] = false;
+        while (top > 0) {
+            int j = stack[--top];
+            int x = j / (SECTION_HEIGHT * CHUNK_SIZE);
+            int y = j / CHUNK_SIZE % SECTION_HEIGHT;
+            int z = j % CHUNK_SIZE;
+            if (z == CHUNK_SIZE - 1) faces |= Face::Front;
+            if (z == 0) faces |= Face::Back;
+            if (y == SECTION_HEIGHT - 1) faces |= Face::Top;
+            if (y == 0) faces |= Face::Bottom;
+            if (x == CHUNK_SIZE - 1) faces |= Face::Right;
+            if (x == 0) faces |= Face::Left;
+            for (int f = 0; f < FACE_COUNT; f++) {
+                int nx = x + face_directions[f][0];
+                int ny = y + face_directions[f][1];
+                int nz = z + face_directions[f][2];
+                if (nx < 0 || nx >= CHUNK_SIZE || ny < 0 || ny >= SECTION_HEIGHT || nz < 0 || nz >= CHUNK_SIZE) {
+                    continue;
+                }
+                int n = (nx * SECTION_HEIGHT + ny) * CHUNK_SIZE + nz;
+                if (open[n]) {
+                    open[n] = false;
+                    stack[top++] = n;
                 }
             }
         }
+        for (int f = 0; f < FACE_COUNT; f++) {
+            if (faces & (1 << f)) {
+                s.connectivity[f] |= faces;
+            }
+        }
     }
 }
 
 /*
  * Update the buffer fields in the given chunk.
  * This will be called at every frame, so the buffers should only actually be
- * recomputed if there was a block update affecting the chunk. This can be
- * determined from the state of the update flag. This method will set the
- * update flag to false.
+ * recomputed if there was a block update affecting the chunk. This is tracked
+ * per section, so only sections whose update flag is set are recomputed. This
+ * method will set the update flags to false.
  */
 void Chunk::update() {
-
-    if (update_) {
-        computePhysicsObjects();
-        computeMesh();
+    for (int s = 0; s < SECTION_COUNT; s++) {
+        if (sections_[s].update_) {
+            sections_[s].blocks.compact();
+            computeConnectivity(s);
+            computeMesh(s);
+        }
+        sections_[s].update_ = FALSE;
     }
-    update_ = FALSE;
 }
\ No newline at end of file
@@ -0,0 +1,54 @@
+#include <voxel/frustum.hpp>
+
+/*
+ * Returns the i-th row of the given column major matrix, as the four
+ * coefficients of a plane equation.
+ */
+static void mat4_row(const mat4_t *m, int i, float row[4]) {
+    for (int j = 0; j < 4; j++) {
+        row[j] = m->entries[j][i];
+    }
+}
+
+/*
+ * Initializes a plane from the coefficients a*x + b*y + c*z + d and
+ * normalizes it so that its distances are in world units.
+ */
+static void plane3_init(plane3_t *self, float a, float b, float c, float d) {
+    float norm = sqrt(a * a + b * b + c * c);
+    vec3_init(&self->normal, a / norm, b / norm, c / norm);
+    self->distance = d / norm;
+}
+
+void frustum_init(frustum_t *self, const mat4_t *m) {
+    float x[4], y[4], z[4], w[4];
+    mat4_row(m, 0, x);
+    mat4_row(m, 1, y);
+    mat4_row(m, 2, z);
+    mat4_row(m, 3, w);
+
+    // -w <= x <= w, -w <= y <= w and -w <= z <= w.
+    plane3_init(&self->planes[0], w[0] + x[0], w[1] + x[1], w[2] + x[2], w[3] + x[3]);
+    plane3_init(&self->planes[1], w[0] - x[0], w[1] - x[1], w[2] - x[2], w[3] - x[3]);
+    plane3_init(&self->planes[2], w[0] + y[0], w[1] + y[1], w[2] + y[2], w[3] + y[3]);
+    plane3_init(&self->planes[3], w[0] - y[0], w[1] - y[1], w[2] - y[2], w[3] - y[3]);
+    plane3_init(&self->planes[4], w[0] + z[0], w[1] + z[1], w[2] + z[2], w[3] + z[3]);
+    plane3_init(&self->planes[5], w[0] - z[0], w[1] - z[1], w[2] - z[2], w[3] - z[3]);
+}
+
+int frustum_intersects_aabb(const frustum_t *self, const aabb3_t *box) {
+    for (int i = 0; i < 6; i++) {
+        const plane3_t *plane = &self->planes[i];
+        // The signed distance of the corner of the box farthest along the
+        // plane normal is the distance of its center plus the projection of
+        // its half extents onto the normal.
+        float center = vec3_dot(&plane->normal, &box->position) + plane->distance;
+        float radius = box->size.x * abs(plane->normal.x)
+                     + box->size.y * abs(plane->normal.y)
+                     + box->size.z * abs(plane->normal.z);
+        if (center + radius < 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
@@ -42,6 +42,12 @@ void vec3_scale(const vec3_t *a, float b, vec3_t *c) {
     c->z = b * a->z;
 }
 
+void vec3_lerp(const vec3_t *a, const vec3_t *b, float t, vec3_t *c) {
+    c->x = a->x + t * (b->x - a->x);
+    c->y = a->y + t * (b->y - a->y);
+    c->z = a->z + t * (b->z - a->z);
+}
+
 float vec3_distance(const vec3_t *a, const vec3_t *b) {
     float u = a->x - b->x;
     float v = a->y - b->y;
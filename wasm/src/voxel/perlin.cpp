@@ -1,4 +1,7 @@
+#include <libc/stdint.hpp>
+#include <libc/stdlib.hpp>
 #include <voxel/Perlin.hpp>
+#include <voxel/Browser.hpp>
 #include <libc/math.hpp>
 
 static const int  SEED = 1985;
@@ -72,4 +75,142 @@ double perlin2d(double x, double y, double freq, int depth)
         ya *= 2;
     }
     return fin/div;
-}
\ No newline at end of file
+}
+
+/*
+ * The number of columns of a grid row processed at once by perlin2d_grid.
+ */
+#define PERLIN_GRID_BLOCK 64
+
+/*
+ * The grid size used by perlin_benchmark, matching one chunk of terrain.
+ */
+#define CHUNK_GRID_SIZE 16
+
+/*
+ * Rounds towards negative infinity without calling into javascript.
+ */
+static inline int ifloor(double v)
+{
+    int i = (int) v;
+    return i - (v < i);
+}
+
+static inline float smooth(float s)
+{
+    return s * s * (3 - 2 * s);
+}
+
+void perlin2d_grid(float *out, int x, int y, int width, int height, double freq, int depth)
+{
+    int x_int[PERLIN_GRID_BLOCK];
+    float x_smooth[PERLIN_GRID_BLOCK];
+    float s[PERLIN_GRID_BLOCK];
+    float t[PERLIN_GRID_BLOCK];
+    float u[PERLIN_GRID_BLOCK];
+    float v[PERLIN_GRID_BLOCK];
+    float fin[PERLIN_GRID_BLOCK];
+
+    float div = 0.0;
+    float amp = 1.0;
+    for (int o = 0; o < depth; o++) {
+        div += 256 * amp;
+        amp /= 2;
+    }
+
+    for (int j = 0; j < height; j++) {
+        for (int i0 = 0; i0 < width; i0 += PERLIN_GRID_BLOCK) {
+            int n = width - i0 < PERLIN_GRID_BLOCK ? width - i0: PERLIN_GRID_BLOCK;
+            for (int i = 0; i < n; i++) {
+                fin[i] = 0;
+            }
+
+            double f = freq;
+            amp = 1.0;
+            for (int o = 0; o < depth; o++) {
+                // Every sample in the row shares its y lattice coordinate.
+                double ya = (y + j) * f;
+                int y_int = ifloor(ya);
+                float y_smooth = smooth(ya - y_int);
+                int h0 = HASH[(y_int + SEED) & 255];
+                int h1 = HASH[(y_int + 1 + SEED) & 255];
+
+                // The start of the block is split into its lattice cell and
+                // fraction in double precision, so that the per-sample offsets
+                // are small and non-negative and stay exact in single precision.
+                double xa = (x + i0) * f;
+                int x_base = ifloor(xa);
+                float x_frac = xa - x_base;
+                float step = f;
+                for (int i = 0; i < n; i++) {
+                    float xi = x_frac + i * step;
+                    int cell = (int) xi;
+                    x_int[i] = x_base + cell;
+                    x_smooth[i] = smooth(xi - cell);
+                }
+
+                for (int i = 0; i < n; i++) {
+                    s[i] = HASH[(h0 + x_int[i]) & 255];
+                    t[i] = HASH[(h0 + x_int[i] + 1) & 255];
+                    u[i] = HASH[(h1 + x_int[i]) & 255];
+                    v[i] = HASH[(h1 + x_int[i] + 1) & 255];
+                }
+
+                for (int i = 0; i < n; i++) {
+                    float low = s[i] + x_smooth[i] * (t[i] - s[i]);
+                    float high = u[i] + x_smooth[i] * (v[i] - u[i]);
+                    fin[i] += amp * (low + y_smooth * (high - low));
+                }
+
+                f *= 2;
+                amp /= 2;
+            }
+
+            for (int i = 0; i < n; i++) {
+                out[j * width + i0 + i] = fin[i] / div;
+            }
+        }
+    }
+}
+
+void perlin_benchmark(int iterations)
+{
+    if (iterations < 1) {
+        return;
+    }
+
+    // Every grid produced by the timed loops is kept, so that the output of
+    // both implementations is consumed and the comparison below checks
+    // exactly what was timed.
+    const int grid_area = CHUNK_GRID_SIZE * CHUNK_GRID_SIZE;
+    float *grid = (float *) malloc(iterations * grid_area * sizeof(float));
+    float *scalar = (float *) malloc(iterations * grid_area * sizeof(float));
+
+    double start = now();
+    for (int n = 0; n < iterations; n++) {
+        for (int j = 0; j < CHUNK_GRID_SIZE; j++) {
+            for (int i = 0; i < CHUNK_GRID_SIZE; i++) {
+                scalar[n * grid_area + j * CHUNK_GRID_SIZE + i] = perlin2d(n * CHUNK_GRID_SIZE + i, j, 0.05, 3);
+            }
+        }
+    }
+    double scalar_time = now() - start;
+
+    start = now();
+    for (int n = 0; n < iterations; n++) {
+        perlin2d_grid(grid + n * grid_area, n * CHUNK_GRID_SIZE, 0, CHUNK_GRID_SIZE, CHUNK_GRID_SIZE, 0.05, 3);
+    }
+    double grid_time = now() - start;
+
+    float error = 0;
+    for (int i = 0; i < iterations * grid_area; i++) {
+        float e = abs(grid[i] - scalar[i]);
+        error = e > error ? e: error;
+    }
+    free(grid);
+    free(scalar);
+
+    print_float(scalar_time);
+    print_float(grid_time);
+    print_float(error);
+}
@@ -22,6 +22,10 @@ int aabb3_contains(const aabb3_t *a, const vec3_t *b) {
         && abs(a->position.z - b->z) < a->size.z + epsilon;
 }
 
+void dyn_aabb3_interpolate(const dyn_aabb3_t *a, float alpha, vec3_t *position) {
+    vec3_lerp(&a->previous_position, &a->position, alpha, position);
+}
+
 Face aabb3_resolve_collision(const aabb3_t *block, dyn_aabb3_t *player) {
     float x = 0.0;
     float y = 0.0;
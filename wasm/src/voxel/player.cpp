@@ -23,35 +23,27 @@ void Player::setPosition(float x, float y, float z) {
     physics_object.position.x = x;
     physics_object.position.y = y;
     physics_object.position.z = z;
+    physics_object.previous_position = physics_object.position;
     update_ = true;
 }
 
-voxel::Matrix Player::getModelViewMatrix() {
+/*
+ * Returns the model view matrix of the player drawn a fraction `alpha` of a
+ * physics step after its previous position.
+ */
+voxel::Matrix Player::getModelViewMatrix(float alpha) {
+    vec3_t position;
+    dyn_aabb3_interpolate(&physics_object, alpha, &position);
     voxel::Matrix matrix = voxel::Matrix::RotateY(theta) * voxel::Matrix::Translate({
-        physics_object.position.x,
-        physics_object.position.y,
-        physics_object.position.z
+        position.x,
+        position.y,
+        position.z
     }); 
     return matrix;
 }
 
 void Player::update(float dt) {
-        physics_object.position.x += dt * physics_object.velocity.x;
-        physics_object.position.y += dt * physics_object.velocity.y;
-        physics_object.position.z += dt * physics_object.velocity.z;
-
-        auto pchunk = chunk();
-        int bottom = Face::None;
-        for (auto chunk: this->world_->chunks_) {
-            if (abs(chunk->x() - pchunk[0]) <= 1 
-            || abs(chunk->z() - pchunk[1]) <= 1) {
-                for (auto &block: chunk->physicsObjects()) {
-                    if (aabb3_intersects(&block, (aabb3_t *) &physics_object)) {
-                        bottom = bottom | aabb3_resolve_collision(&block, &physics_object);
-                    }
-                }
-            }
-        }
+        int bottom = world_move_body(world_, &physics_object, dt);
 
         if (!(bottom & Face::Bottom)) {
         physics_object.velocity.y -= dt * 20;
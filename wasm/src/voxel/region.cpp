@@ -0,0 +1,196 @@
+#include <libc/stdlib.hpp>
+#include <voxel/region.hpp>
+#include <voxel/Browser.hpp>
+
+/*
+ * Divides a chunk coordinate by REGION_SIZE, rounding towards negative
+ * infinity so that negative chunk coordinates map to the correct region.
+ */
+static int region_coordinate(int x) {
+    return x >= 0 ? x / REGION_SIZE: (x - REGION_SIZE + 1) / REGION_SIZE;
+}
+
+/*
+ * Writes the decimal representation of n to the given buffer and returns a
+ * pointer to the end of the written characters.
+ */
+static char* write_int(char *str, int n) {
+    if (n < 0) {
+        *str++ = '-';
+        n = -n;
+    }
+    char digits[16];
+    int count = 0;
+    do {
+        digits[count++] = '0' + n % 10;
+        n /= 10;
+    } while (n > 0);
+    while (count > 0) {
+        *str++ = digits[--count];
+    }
+    return str;
+}
+
+/*
+ * Writes the name of the region file containing the given chunk, of the form
+ * "region.<x>.<z>", to the given buffer.
+ */
+static void region_name(int x, int z, char *name) {
+    const char *prefix = "region.";
+    while (*prefix != '\0') {
+        *name++ = *prefix++;
+    }
+    name = write_int(name, region_coordinate(x));
+    *name++ = '.';
+    name = write_int(name, region_coordinate(z));
+    *name = '\0';
+}
+
+/*
+ * Returns the byte offset of the offset table entry of the given chunk.
+ */
+static int region_entry_offset(int x, int z) {
+    int local_x = x - region_coordinate(x) * REGION_SIZE;
+    int local_z = z - region_coordinate(z) * REGION_SIZE;
+    return (local_x * REGION_SIZE + local_z) * sizeof(region_entry_t);
+}
+
+/*
+ * The longest run encoded by a single control byte of the payload encoding,
+ * for both literal runs and repeated bytes.
+ */
+#define REGION_MAX_LITERAL 128
+#define REGION_MAX_REPEAT 129
+
+/*
+ * New slots are larger than their payload by one REGION_SLOT_HEADROOM'th of
+ * its size, so that saving a slightly larger payload reuses the slot.
+ */
+#define REGION_SLOT_HEADROOM 4
+
+/*
+ * Compresses a chunk payload with a PackBits style run length encoding. Each
+ * control byte c below 128 is followed by c + 1 literal bytes, and each
+ * control byte of 128 or more is followed by a single byte repeated
+ * c - 126 times. Sections are mostly a single block type, so their packed
+ * block data consists largely of long runs of identical bytes, while data
+ * without runs grows by at most one byte in REGION_MAX_LITERAL.
+ */
+static void region_compress(const uint8_t *data, unsigned int length, voxel::ArrayList<uint8_t> &out) {
+    unsigned int i = 0;
+    while (i < length) {
+        unsigned int run = 1;
+        while (i + run < length && run < REGION_MAX_REPEAT && data[i + run] == data[i]) {
+            run++;
+        }
+        if (run >= 2) {
+            out.append(run + 126);
+            out.append(data[i]);
+            i += run;
+            continue;
+        }
+
+        // Gather literal bytes up to the start of the next run.
+        unsigned int literal = 1;
+        while (i + literal < length && literal < REGION_MAX_LITERAL
+            && !(i + literal + 1 < length && data[i + literal] == data[i + literal + 1])) {
+            literal++;
+        }
+        out.append(literal - 1);
+        for (unsigned int k = 0; k < literal; k++) {
+            out.append(data[i + k]);
+        }
+        i += literal;
+    }
+}
+
+/*
+ * Reverses region_compress.
+ * \returns false if the encoded data is truncated.
+ */
+static bool region_decompress(const uint8_t *data, unsigned int length, voxel::ArrayList<uint8_t> &out) {
+    unsigned int i = 0;
+    while (i < length) {
+        int control = data[i++];
+        if (control < REGION_MAX_LITERAL) {
+            if (i + control + 1 > length) return false;
+            for (int k = 0; k <= control; k++) {
+                out.append(data[i++]);
+            }
+        } else {
+            if (i >= length) return false;
+            for (int k = 0; k < control - 126; k++) {
+                out.append(data[i]);
+            }
+            i++;
+        }
+    }
+    return true;
+}
+
+Chunk* region_load_chunk(World *world, int x, int z) {
+    char name[32];
+    region_name(x, z, name);
+    if (storage_size(name) < (int) REGION_TABLE_SIZE) {
+        return nullptr;
+    }
+
+    region_entry_t entry;
+    if (storage_read(name, &entry, region_entry_offset(x, z), sizeof(entry)) != (int) sizeof(entry)) {
+        return nullptr;
+    }
+    if (entry.offset == 0) {
+        return nullptr;
+    }
+
+    uint8_t *payload = (uint8_t *) malloc(entry.length);
+    voxel::ArrayList<uint8_t> blocks;
+    Chunk *chunk = nullptr;
+    if (storage_read(name, payload, entry.offset, entry.length) == (int) entry.length
+    &&  region_decompress(payload, entry.length, blocks)) {
+        chunk = new Chunk(world, x, z);
+        if (!chunk->load(blocks.buffer(), blocks.size())) {
+            delete chunk;
+            chunk = nullptr;
+        }
+    }
+    free(payload);
+    return chunk;
+}
+
+void region_save_chunk(Chunk *chunk) {
+    char name[32];
+    region_name(chunk->x(), chunk->z(), name);
+
+    int size = storage_size(name);
+    if (size < (int) REGION_TABLE_SIZE) {
+        uint8_t *table = (uint8_t *) malloc(REGION_TABLE_SIZE);
+        memset(table, 0, REGION_TABLE_SIZE);
+        storage_write(name, table, 0, REGION_TABLE_SIZE);
+        free(table);
+        size = REGION_TABLE_SIZE;
+    }
+
+    voxel::ArrayList<uint8_t> blocks;
+    voxel::ArrayList<uint8_t> payload;
+    chunk->save(blocks);
+    region_compress(blocks.buffer(), blocks.size(), payload);
+
+    // Reuse the slot of the previously saved copy of the chunk if the new
+    // payload fits, and otherwise append a new slot to the end of the file.
+    // New slots have room for the payload to grow, since an edited chunk
+    // usually compresses to a slightly larger payload.
+    region_entry_t entry;
+    int entry_offset = region_entry_offset(chunk->x(), chunk->z());
+    if (storage_read(name, &entry, entry_offset, sizeof(entry)) != (int) sizeof(entry)
+    ||  entry.offset == 0 || payload.size() > entry.capacity) {
+        entry.offset = size;
+        entry.capacity = payload.size() + payload.size() / REGION_SLOT_HEADROOM;
+        uint8_t end = 0;
+        storage_write(name, &end, entry.offset + entry.capacity - 1, 1);
+    }
+    entry.length = payload.size();
+
+    storage_write(name, payload.buffer(), entry.offset, payload.size());
+    storage_write(name, &entry, entry_offset, sizeof(entry));
+}
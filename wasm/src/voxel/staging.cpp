@@ -0,0 +1,9 @@
+#include <voxel/staging.hpp>
+
+staging_region_t vertex_staging_region;
+staging_region_t index_staging_region;
+
+void staging_map(staging_region_t *region, const void *data, uint32_t size) {
+    region->data = (uint8_t *) data;
+    region->size = size;
+}
@@ -9,6 +9,7 @@
 #include <voxel/Item.hpp>
 #include <util/Fetch.hpp>
 #include <voxel/Perlin.hpp>
+#include <voxel/region.hpp>
 
 voxel::Mesh* Block::blocks[256];
 /*
@@ -42,7 +43,10 @@ int World::sea_level() {
 }
 
 int World::elevation(int x, int z) {
-    float noise = perlin2d(x , z, 0.05, 3);
+    return elevation(perlin2d(x , z, TERRAIN_FREQUENCY, TERRAIN_OCTAVES));
+}
+
+int World::elevation(float noise) {
     return 20 * noise + sea_level() - 5;
 }
 
@@ -54,16 +58,19 @@ World* world_init() {
 }
 
 World::World(): player{Player{this}} { 
-    vec3_init(&player.physics_object.position, 0,  2 * World::elevation(0, 0), 0.0);
+    player.setPosition(0,  2 * World::elevation(0, 0), 0.0);
     vec3_init(&player.physics_object.size, 0.5, 2.0, 0.5);
     chunk_count = 0;
+    physics_accumulator = 0;
+    interpolation = 0;
+    max_physics_steps = PHYSICS_MAX_STEPS;
 
     // Initialize MOB_COUNT pigs in a random location
     for (int i = 0; i < MOB_COUNT; i++) {
         Player *mob = new Player{this};
         int x = (int)((2 * random() - 1) * 50);
         int z = (int)((2 * random() - 1) * 50);
-        vec3_init(&mob->physics_object.position, x, 2 * World::elevation(x, z), z);
+        mob->setPosition(x, 2 * World::elevation(x, z), z);
         vec3_init(&mob->physics_object.size, 0.8, 2, 1.5);
         mobs_.append(mob);
     }
@@ -80,19 +87,83 @@ void world_destroy(World *self) {
 
 /*
  * Retrieves the chunk at the given coordinates.
- * Currently, this function is implemented as a linear search.
- * A more optimized approach should be taken to improve time complexity,
- * especially as number of chunks increases. As a short term alternative,
- * we could make this a 'move-to-front' list which 'caches' recently accessed
- * chunks by storing them at the front of the list.
+ * Chunks are indexed by their chunk coordinates in an open-addressing hash
+ * map, so this lookup takes constant time regardless of how many chunks have
+ * been loaded.
  */
 Chunk* world_get_chunk(World *self, int x, int z) {
-    for (auto &chunk: self->chunks_){
-        if (chunk->x() == x && chunk->z() == z) {
-            return chunk;
+    Chunk **chunk = self->chunk_index_.lookup(x, z);
+    return chunk != nullptr ? *chunk: nullptr;
+}
+
+/*
+ * Adds the given chunk to the world at the given chunk coordinates.
+ * Returns 1 if the chunk was added and 0 if a chunk already exists at the
+ * given coordinates.
+ */
+int world_set_chunk(World *self, int x, int z, Chunk *chunk) {
+    if (self->chunk_index_.lookup(x, z) != nullptr) {
+        return 0;
+    }
+    world_evict_chunks(self);
+    self->chunks_.append(chunk);
+    self->chunk_index_.insert(x, z, chunk);
+    self->chunk_count += 1;
+    return 1;
+}
+
+/*
+ * Removes the chunk at index i of the chunk list from the world and destroys
+ * it. Chunks which have changed since they were last saved are written to
+ * their region file first, so they are restored rather than regenerated when
+ * the player returns. Destroying a chunk frees its block storage and physics
+ * objects and releases the GPU buffers of its meshes.
+ */
+void world_remove_chunk(World *self, int i) {
+    Chunk *chunk = self->chunks_[i];
+    if (!chunk->saved()) {
+        region_save_chunk(chunk);
+    }
+    self->chunk_index_.erase(chunk->x(), chunk->z());
+    self->chunks_.remove(i);
+    self->chunk_count -= 1;
+    delete chunk;
+}
+
+/*
+ * Chunks within VISIBLE_CHUNK_RADIUS of the player, measured in chessboard
+ * distance, are never evicted. There must always be fewer of them than
+ * CHUNK_CAPACITY, so that eviction can make room for a new chunk and the
+ * world never grows past its capacity.
+ */
+static_assert((2 * VISIBLE_CHUNK_RADIUS + 1) * (2 * VISIBLE_CHUNK_RADIUS + 1) < CHUNK_CAPACITY,
+    "the chunks around the player must fit below CHUNK_CAPACITY");
+
+/*
+ * Evicts chunks until there is room for at least one more chunk below
+ * CHUNK_CAPACITY. The chunk farthest from the player is evicted first. Chunks
+ * within VISIBLE_CHUNK_RADIUS of the player are never evicted, since they
+ * would immediately be regenerated; the assertion above guarantees that some
+ * other chunk can always be evicted.
+ */
+void world_evict_chunks(World *self) {
+    auto pchunk = self->player.chunk();
+    while (self->chunks_.size() >= CHUNK_CAPACITY) {
+        int farthest = -1;
+        float farthest_distance = VISIBLE_CHUNK_RADIUS;
+        for (size_t i = 0; i < self->chunks_.size(); i++) {
+            Chunk *chunk = self->chunks_[i];
+            float distance = max(abs(chunk->x() - pchunk[0]), abs(chunk->z() - pchunk[1]));
+            if (distance > farthest_distance) {
+                farthest = i;
+                farthest_distance = distance;
+            }
         }
+        if (farthest == -1) {
+            break;
+        }
+        world_remove_chunk(self, farthest);
     }
-    return nullptr;
 }
 
 Block world_set_block(World *self, int x, int y, int z, Block b) {
@@ -107,6 +178,237 @@ Block world_set_block(World *self, int x, int y, int z, Block b) {
     return old;
 }
 
+/*
+ * Returns the block at the given world coordinates, or air if the block lies
+ * in a chunk which is not loaded or outside the world.
+ */
+Block world_get_block(World *self, int x, int y, int z) {
+    if (y < 0 || y >= CHUNK_HEIGHT) {
+        return Block::Air;
+    }
+    int chunkX = floor((float) x / CHUNK_SIZE);
+    int chunkZ = floor((float) z / CHUNK_SIZE);
+    Chunk *chunk = world_get_chunk(self, chunkX, chunkZ);
+    if (chunk == nullptr) {
+        return Block::Air;
+    }
+    return chunk->getBlock(x - chunkX * CHUNK_SIZE, y, z - chunkZ * CHUNK_SIZE);
+}
+
+int world_resolve_collisions(World *self, dyn_aabb3_t *body) {
+    // Block (x, y, z) spans the world coordinates from 2x - 1 to 2x + 1 along
+    // each axis.
+    int x0 = floor((body->position.x - body->size.x + 1) / 2);
+    int x1 = floor((body->position.x + body->size.x + 1) / 2);
+    int y0 = floor((body->position.y - body->size.y + 1) / 2);
+    int y1 = floor((body->position.y + body->size.y + 1) / 2);
+    int z0 = floor((body->position.z - body->size.z + 1) / 2);
+    int z1 = floor((body->position.z + body->size.z + 1) / 2);
+    y0 = y0 < 0 ? 0: y0;
+    y1 = y1 >= CHUNK_HEIGHT ? CHUNK_HEIGHT - 1: y1;
+
+    int faces = Face::None;
+    world_query_chunks(self, (aabb3_t *) body, [&](Chunk *chunk) {
+        // Visit the cells of the body which lie within this chunk.
+        int cx = chunk->x() * CHUNK_SIZE;
+        int cz = chunk->z() * CHUNK_SIZE;
+        int lx0 = x0 > cx ? x0 - cx: 0;
+        int lx1 = x1 < cx + CHUNK_SIZE - 1 ? x1 - cx: CHUNK_SIZE - 1;
+        int lz0 = z0 > cz ? z0 - cz: 0;
+        int lz1 = z1 < cz + CHUNK_SIZE - 1 ? z1 - cz: CHUNK_SIZE - 1;
+        for (int x = lx0; x <= lx1; x++) {
+            for (int y = y0; y <= y1; y++) {
+                for (int z = lz0; z <= lz1; z++) {
+                    if (!chunk->getBlock(x, y, z).solid()) {
+                        continue;
+                    }
+                    aabb3_t block;
+                    vec3_init(&block.position, 2 * (cx + x), 2 * y, 2 * (cz + z));
+                    vec3_init(&block.size, 1, 1, 1);
+                    if (aabb3_intersects(&block, (aabb3_t *) body)) {
+                        faces |= aabb3_resolve_collision(&block, body);
+                    }
+                }
+            }
+        }
+    });
+    return faces;
+}
+
+/*
+ * The tolerance, in blocks, within which a body is considered to touch a
+ * block rather than overlap it. This absorbs the rounding error in the
+ * position of a body stopped flush against a block.
+ */
+#define SWEEP_EPSILON 1E-3f
+
+/*
+ * Moves the body by `distance` along the given axis (0, 1 or 2 for x, y or
+ * z), stopping it flush against the nearest solid block in its path. Only
+ * the blocks swept by the leading face of the body are tested; blocks which
+ * the body already overlaps or merely touches from the side are ignored.
+ * \returns true if the body was stopped by a block.
+ */
+static bool world_sweep_axis(World *self, dyn_aabb3_t *body, int axis, float distance) {
+    if (distance == 0) {
+        return false;
+    }
+    float *position = (float *) &body->position;
+    float *size = (float *) &body->size;
+
+    // The range of cells swept by the body in block coordinates, in which
+    // block i spans [i, i + 1] along each axis.
+    int lo[3];
+    int hi[3];
+    for (int i = 0; i < 3; i++) {
+        lo[i] = floor((position[i] - size[i] + 1) / 2 + SWEEP_EPSILON);
+        hi[i] = floor((position[i] + size[i] + 1) / 2 - SWEEP_EPSILON);
+    }
+    float lead = (position[axis] + (distance > 0 ? size[axis]: -size[axis]) + 1) / 2;
+    float target = lead + distance / 2;
+    if (distance > 0) {
+        lo[axis] = -floor(SWEEP_EPSILON - lead);
+        hi[axis] = -floor(-target) - 1;
+    } else {
+        lo[axis] = floor(target);
+        hi[axis] = floor(lead + SWEEP_EPSILON) - 1;
+    }
+    lo[1] = lo[1] < 0 ? 0: lo[1];
+    hi[1] = hi[1] >= CHUNK_HEIGHT ? CHUNK_HEIGHT - 1: hi[1];
+
+    // Find the cell nearest to the leading face which contains a solid block.
+    int nearest = distance > 0 ? hi[axis] + 1: lo[axis] - 1;
+    if (lo[0] <= hi[0] && lo[1] <= hi[1] && lo[2] <= hi[2]) {
+        aabb3_t swept;
+        vec3_init(&swept.position, lo[0] + hi[0], lo[1] + hi[1], lo[2] + hi[2]);
+        vec3_init(&swept.size, hi[0] - lo[0] + 1, hi[1] - lo[1] + 1, hi[2] - lo[2] + 1);
+        world_query_chunks(self, &swept, [&](Chunk *chunk) {
+            int cx = chunk->x() * CHUNK_SIZE;
+            int cz = chunk->z() * CHUNK_SIZE;
+            int x0 = lo[0] > cx ? lo[0]: cx;
+            int x1 = hi[0] < cx + CHUNK_SIZE - 1 ? hi[0]: cx + CHUNK_SIZE - 1;
+            int z0 = lo[2] > cz ? lo[2]: cz;
+            int z1 = hi[2] < cz + CHUNK_SIZE - 1 ? hi[2]: cz + CHUNK_SIZE - 1;
+            for (int x = x0; x <= x1; x++) {
+                for (int y = lo[1]; y <= hi[1]; y++) {
+                    for (int z = z0; z <= z1; z++) {
+                        if (chunk->getBlock(x - cx, y, z - cz).solid()) {
+                            int cell[3] = {x, y, z};
+                            if (distance > 0 ? cell[axis] < nearest: cell[axis] > nearest) {
+                                nearest = cell[axis];
+                            }
+                        }
+                    }
+                }
+            }
+        });
+    }
+
+    if (nearest < lo[axis] || nearest > hi[axis]) {
+        position[axis] += distance;
+        return false;
+    }
+    if (distance > 0) {
+        position[axis] = 2 * nearest - 1 - size[axis];
+    } else {
+        position[axis] = 2 * nearest + 1 + size[axis];
+    }
+    return true;
+}
+
+int world_move_body(World *self, dyn_aabb3_t *body, float dt) {
+    int faces = Face::None;
+    if (world_sweep_axis(self, body, 1, dt * body->velocity.y)) {
+        faces |= body->velocity.y < 0 ? Face::Bottom: Face::Top;
+    }
+    if (world_sweep_axis(self, body, 0, dt * body->velocity.x)) {
+        faces |= body->velocity.x < 0 ? Face::Left: Face::Right;
+    }
+    if (world_sweep_axis(self, body, 2, dt * body->velocity.z)) {
+        faces |= body->velocity.z < 0 ? Face::Front: Face::Back;
+    }
+
+    // A body resting on a block does not move into it, so probe just below
+    // the body for ground.
+    dyn_aabb3_t probe = *body;
+    if (!(faces & Face::Bottom) && body->velocity.y <= 0 && world_sweep_axis(self, &probe, 1, -4 * SWEEP_EPSILON)) {
+        faces |= Face::Bottom;
+    }
+
+    // Push the body out of any block it still overlaps, such as a block
+    // placed inside it.
+    return faces | world_resolve_collisions(self, body);
+}
+
+/*
+ * An implementation of the voxel traversal algorithm of Amanatides and Woo.
+ * The ray is expressed in block coordinates, in which block (x, y, z) spans
+ * the unit cube from (x, y, z) to (x + 1, y + 1, z + 1). For each axis,
+ * `next` holds the distance along the ray at which it crosses the next
+ * block boundary on that axis and `delta` holds the distance between
+ * boundaries. Each iteration steps into the neighbouring block across the
+ * nearest boundary, so every block pierced by the ray is visited in order.
+ */
+IntersectionResult world_raycast(World *self, const ray3_t *ray, float distance) {
+    // Blocks are two units wide and centered on even world coordinates.
+    float origin[3] = {
+        (ray->position.x + 1) / 2,
+        (ray->position.y + 1) / 2,
+        (ray->position.z + 1) / 2,
+    };
+    float direction[3] = {ray->direction.x, ray->direction.y, ray->direction.z};
+    float max_t = distance / 2;
+
+    // The side of a block entered when stepping in the positive or negative
+    // direction of each axis.
+    const IntersectionResult::Value positive_sides[3] = {
+        IntersectionResult::Left, IntersectionResult::Bottom, IntersectionResult::Front
+    };
+    const IntersectionResult::Value negative_sides[3] = {
+        IntersectionResult::Right, IntersectionResult::Top, IntersectionResult::Back
+    };
+
+    int block[3];
+    int step[3];
+    float next[3];
+    float delta[3];
+    for (int i = 0; i < 3; i++) {
+        block[i] = floor(origin[i]);
+        if (direction[i] > 0) {
+            step[i] = 1;
+            delta[i] = 1 / direction[i];
+            next[i] = (block[i] + 1 - origin[i]) * delta[i];
+        } else if (direction[i] < 0) {
+            step[i] = -1;
+            delta[i] = -1 / direction[i];
+            next[i] = (origin[i] - block[i]) * delta[i];
+        } else {
+            step[i] = 0;
+            delta[i] = 1E10f;
+            next[i] = 1E10f;
+        }
+    }
+
+    while (true) {
+        int axis = 0;
+        if (next[1] < next[axis]) axis = 1;
+        if (next[2] < next[axis]) axis = 2;
+        float t = next[axis];
+        if (t > max_t) {
+            break;
+        }
+        block[axis] += step[axis];
+        next[axis] += delta[axis];
+
+        Block b = world_get_block(self, block[0], block[1], block[2]);
+        if (b.solid()) {
+            IntersectionResult::Value side = step[axis] > 0 ? positive_sides[axis]: negative_sides[axis];
+            return {side, 2 * t, block[0], block[1], block[2]};
+        }
+    }
+    return {IntersectionResult::None, 1E10f, nullptr};
+}
+
 void world_break_block(World *self, int x, int y, int z) {
     Block b = world_set_block(self, x, y, z, Block::Air);
     block_update_t data;
@@ -143,7 +445,7 @@ float* world_get_projection_matrix(World *self, float aspect) {
     mat4_projection(fov, near, far, aspect, &self->projection_matrix);
     mat4_rotate_x(self->player.phi, &rotation_x_matrix);
     mat4_rotate_y(self->player.theta, &rotation_y_matrix);
-    mat4_translate(-self->player.physics_object.position.x, -self->player.physics_object.position.y, -self->player.physics_object.position.z, &translate_matrix);
+    mat4_translate(-self->camera_position.x, -self->camera_position.y, -self->camera_position.z, &translate_matrix);
 
     mat4_multiply(&rotation_x_matrix, &self->projection_matrix, &self->projection_matrix);
     mat4_multiply(&rotation_y_matrix, &self->projection_matrix, &self->projection_matrix);
@@ -189,24 +491,11 @@ int world_update(World *self, float dt) {
         self->player.physics_object.velocity.z = velocity_left.z;
     }
     
-    self->player.physics_object.position.x += dt * self->player.physics_object.velocity.x;
-    self->player.physics_object.position.y += dt * self->player.physics_object.velocity.y;
-    self->player.physics_object.position.z += dt * self->player.physics_object.velocity.z;
+    int bottom = world_move_body(self, &self->player.physics_object, dt);
 
     self->player.physics_object.velocity.y += dt * self->player.physics_object.velocity.y;
 
     auto pchunk = self->player.chunk();
-    int bottom = Face::None;
-    for (auto chunk: self->chunks_) {
-        if (abs(chunk->x() - pchunk[0]) <= 1 
-         || abs(chunk->z() - pchunk[1]) <= 1) {
-            for (auto &block: chunk->physicsObjects()) {
-                if (aabb3_intersects(&block, (aabb3_t *) &self->player.physics_object)) {
-                    bottom = bottom | aabb3_resolve_collision(&block, &self->player.physics_object);
-                }
-            }
-        }
-    }
 
 
     if ((bottom & Face::Bottom)) {
@@ -233,7 +522,7 @@ int world_update(World *self, float dt) {
             auto mchunk1 = mob1->chunk();
             auto mchunk2 = mob2->chunk();
             if (abs(mchunk1[0] - mchunk2[0]) <= 1
-            ||  abs(mchunk1[1] - mchunk2[1]) <= 1) {
+            &&  abs(mchunk1[1] - mchunk2[1]) <= 1) {
                 if (aabb3_intersects((aabb3_t *) aabb1, (aabb3_t *) aabb2)) {
                     aabb3_resolve_collision((aabb3_t *) aabb1, aabb2);
                 }
@@ -244,7 +533,7 @@ int world_update(World *self, float dt) {
     for (auto mob: self->mobs_) {
         auto mchunk = mob->chunk();
         if (abs(pchunk[0] - mchunk[0]) <= 1
-        ||  abs(pchunk[1] - mchunk[1]) <= 1) {
+        &&  abs(pchunk[1] - mchunk[1]) <= 1) {
             if (aabb3_intersects((aabb3_t *) &mob->physics_object, (aabb3_t *) &self->player.physics_object)) {
                 aabb3_resolve_collision((aabb3_t *) &mob->physics_object, &self->player.physics_object);
                 self->player.physics_object.velocity.x = 2 * mob->physics_object.velocity.x;
@@ -265,30 +554,17 @@ int world_update(World *self, float dt) {
     }
 
     for (int p = 0; p < self->items.size(); p++) {
-        if (self->items[p] == nullptr) {
-            continue;
-        }
-
         dyn_aabb3_t *item = &self->items[p]->physics_object;
-        item->position.x += dt * item->velocity.x;
-        item->position.y += dt * item->velocity.y;
-        item->position.z += dt * item->velocity.z;
+        int bottom = world_move_body(self, item, dt);
 
+        // Picked up items are swap-removed, so the item moved into slot p
+        // must be visited next.
         if (aabb3_intersects((aabb3_t *) &self->items[p]->physics_object, (aabb3_t *) &self->player.physics_object)) {
             self->player.addBlock(self->items[p]->block());
             delete self->items[p];
-            self->items[p] = nullptr;
-        }
-
-        int bottom = Face::None;
-        for (auto &chunk: self->chunks_) {
-            auto &blocks = chunk->physicsObjects();
-            for (int j = 0; j < blocks.size(); j++) {
-                aabb3_t *block = &blocks[j];
-                if (aabb3_intersects(block, (aabb3_t *) item)) {
-                    bottom = bottom | aabb3_resolve_collision(block, item);
-                }
-            }
+            self->items.remove(p);
+            p--;
+            continue;
         }
 
         if (!(bottom & Face::Bottom)) {
@@ -299,6 +575,13 @@ int world_update(World *self, float dt) {
 
     }
 
+    return bottom;
+}
+
+/*
+ * Sends the position of the player to the server.
+ */
+static void world_send_position(World *self) {
     position_update_t data;
     data.message = POSITION_UPDATE;
     data.pid = get_pid();
@@ -306,19 +589,73 @@ int world_update(World *self, float dt) {
     data.y = self->player.physics_object.position.y / 2;
     data.z = self->player.physics_object.position.z / 2;
     send(&data, sizeof(data));
+}
 
+/*
+ * Loads or generates the chunks within VISIBLE_CHUNK_RADIUS of the player.
+ */
+static void world_stream_chunks(World *self) {
     int center_x = self->player.physics_object.position.x / 2 / CHUNK_SIZE;
     int center_z = self->player.physics_object.position.z / 2 / CHUNK_SIZE;
 
     for (int chunk_x = -VISIBLE_CHUNK_RADIUS; chunk_x < VISIBLE_CHUNK_RADIUS; chunk_x++) {
         for (int chunk_z = -VISIBLE_CHUNK_RADIUS; chunk_z < VISIBLE_CHUNK_RADIUS; chunk_z++) {
-            Chunk *chunk = world_get_chunk(self, chunk_x + center_x, chunk_z + center_z);
+            int x = chunk_x + center_x;
+            int z = chunk_z + center_z;
+            Chunk *chunk = world_get_chunk(self, x, z);
             if (chunk == nullptr) {
-                self->chunks_.append(new Chunk({self, chunk_x + center_x, chunk_z + center_z, 0}));
+                chunk = region_load_chunk(self, x, z);
+                if (chunk == nullptr) {
+                    chunk = new Chunk(self, x, z, 0);
+                }
+                world_set_chunk(self, x, z, chunk);
             }
         }
     }
-    return bottom;
+}
+
+/*
+ * Records the current position of every body as its previous position, at
+ * the start of a physics step.
+ */
+static void world_save_positions(World *self) {
+    self->player.physics_object.previous_position = self->player.physics_object.position;
+    for (auto mob: self->mobs_) {
+        mob->physics_object.previous_position = mob->physics_object.position;
+    }
+    for (auto item: self->items) {
+        item->physics_object.previous_position = item->physics_object.position;
+    }
+}
+
+int world_advance(World *self, float dt) {
+    self->physics_accumulator += dt;
+    int steps = 0;
+    while (self->physics_accumulator >= PHYSICS_TIMESTEP) {
+        if (self->max_physics_steps > 0 && steps == self->max_physics_steps) {
+            self->physics_accumulator -= PHYSICS_TIMESTEP * floor(self->physics_accumulator / PHYSICS_TIMESTEP);
+            break;
+        }
+        world_save_positions(self);
+        world_update(self, PHYSICS_TIMESTEP);
+        self->physics_accumulator -= PHYSICS_TIMESTEP;
+        steps++;
+    }
+    self->interpolation = self->physics_accumulator / PHYSICS_TIMESTEP;
+
+    // Networking and chunk streaming are per frame work rather than physics,
+    // so they run once however many steps were taken.
+    world_send_position(self);
+    world_stream_chunks(self);
+    return steps;
+}
+
+/**
+ * Sets the maximum number of physics steps taken per frame by world_advance.
+ * A value of zero removes the limit.
+ */
+void world_set_max_physics_steps(World *self, int steps) {
+    self->max_physics_steps = steps;
 }
 
 /**
@@ -343,37 +680,20 @@ void world_click_handler(World *self) {
         -sin(self->player.phi), cos(3.14159 - self->player.theta) * cos(self->player.phi)
     );   
  
-    aabb3_t *min_block;
+    // Find the nearest block within reach by walking the block grid along the
+    // ray, so that picking does not depend on the number of loaded chunks.
+    IntersectionResult min = world_raycast(self, &ray, 10);
+    bool min_block = (int) min != IntersectionResult::None;
     Player *min_mob = nullptr;
-    IntersectionResult min = {IntersectionResult::None, 1E10f, nullptr};
-    
-    // Perform ray-cube collision on all block within a radius of 10.
-    // TODO: Further optimization is still possible... We perform intersection
-    // even on chunks that are extremely far away. As the world grows
-    // very large, this will drastically slow down performance.
-    for (auto &chunk: self->chunks_) {
-        for (auto &block: chunk->physicsObjects()) {
-            if (vec3_distance(&player.position, &block.position) < 10) {
-                IntersectionResult res = ray_intersects(&ray, &block);
-                if (res.time() < min.time()) {
-                    min = res;
-                    min_block = &block;
-                }
-            }
-        }
-    }
 
     // Perform ray-cube collision on all mobs within a radius of 10.
-    // TODO: Further optimization is still possible... We perform intersection
-    // even on chunks that are extremely far away. As the world grows
-    // very large, this will drastically slow down performance.
     for (auto mob: self->mobs_){
         dyn_aabb3_t &mob_aabb = mob->physics_object;
         if (vec3_distance(&player.position, &mob_aabb.position) < 10) {
             IntersectionResult res = ray_intersects(&ray, (aabb3_t*) &mob_aabb);
             if (res.time() < min.time()) {
                 min = res;
-                min_block = nullptr;
+                min_block = false;
                 min_mob = mob;
             }
         }
@@ -385,10 +705,9 @@ void world_click_handler(World *self) {
     }
 
     if (min_block) {
-        // Compute the `world coordinates` from the physics objects
-        int x = min_block->position.x / 2;
-        int y = min_block->position.y / 2;
-        int z = min_block->position.z / 2;
+        int x = min.x();
+        int y = min.y();
+        int z = min.z();
 
         // Either place a block or break a block depending on key modifiers...
         if (!is_key_pressed('z')) {
@@ -434,9 +753,11 @@ void world_click_handler(World *self) {
         }
         min_mob->health -= 34;
         if (min_mob->health < 0) {
-            min_mob->physics_object.position.x = self->player.physics_object.position.x + 40 * random() - 10;
-            min_mob->physics_object.position.y = 220;
-            min_mob->physics_object.position.z = self->player.physics_object.position.z + 40 * random() - 10;
+            min_mob->setPosition(
+                self->player.physics_object.position.x + 40 * random() - 10,
+                220,
+                self->player.physics_object.position.z + 40 * random() - 10
+            );
         }
        
     }
@@ -457,6 +778,52 @@ void world_move_handler(World *self, float dx, float dy) {
     self->player.phi += dy * 3.14159;
 }
 
+/**
+ * Selects the algorithm used to build chunk meshes and marks every loaded
+ * chunk for a rebuild. This allows the naive and greedy meshers to be
+ * compared at runtime from the browser console.
+ * 
+ * \param self: the world
+ * \param mode: a MeshMode value
+ */
+void world_set_mesh_mode(World *self, int mode) {
+    Chunk::mesh_mode = (MeshMode) mode;
+    for (auto chunk: self->chunks_) {
+        chunk->invalidate();
+    }
+}
+
+/**
+ * Returns the total number of chunk mesh vertices across all loaded chunks.
+ */
+unsigned int world_get_vertex_count(World *self) {
+    unsigned int count = 0;
+    for (auto chunk: self->chunks_) {
+        count += chunk->vertexCount();
+    }
+    return count;
+}
+
+/**
+ * Returns the total number of bytes of chunk mesh data across all loaded
+ * chunks. Together with `world_get_vertex_count`, this measures the memory
+ * and upload cost of the current mesher.
+ */
+unsigned int world_get_vertex_bytes(World *self) {
+    unsigned int bytes = 0;
+    for (auto chunk: self->chunks_) {
+        bytes += chunk->byteCount();
+    }
+    return bytes;
+}
+
+/**
+ * Returns the culling counters of the last frame drawn.
+ */
+cull_stats_t* world_get_cull_stats(World *self) {
+    return &self->cull_stats;
+}
+
 /**
  * This function is called on a message from the server. 
  * Currently, multiplayer functionality is not implemented, so this function
@@ -468,6 +835,69 @@ void world_message_handler(World *self, void *message) {
    // Does nothing
 }
 
+/*
+ * Returns true if the given chunk lies within VISIBLE_CHUNK_RADIUS of the
+ * player, measured in taxicab coordinates.
+ */
+static bool world_chunk_in_range(World *self, Chunk *chunk) {
+    auto pchunk = self->player.chunk();
+    return abs(chunk->x() - pchunk[0]) + abs(chunk->z() - pchunk[1]) <= VISIBLE_CHUNK_RADIUS;
+}
+
+/*
+ * Finds the chunk sections which may be visible from the camera.
+ * Starting from the section containing the camera, the search crosses from
+ * a section into its neighbour through face `to` only if the face through
+ * which the section was entered can see face `to`, the neighbour intersects
+ * the view frustum, and the search has not travelled in the opposite
+ * direction, since a line of sight never turns back towards the camera.
+ * Sections which are never reached are enclosed by opaque blocks.
+ */
+static void world_find_reachable_sections(World *self) {
+    vec3_t &position = self->camera_position;
+    int block_x = floor((position.x + 1) / 2);
+    int block_y = floor((position.y + 1) / 2);
+    int block_z = floor((position.z + 1) / 2);
+    int section = floor((float) block_y / SECTION_HEIGHT);
+    section = section < 0 ? 0: section >= SECTION_COUNT ? SECTION_COUNT - 1: section;
+
+    Chunk *chunk = world_get_chunk(self, floor((float) block_x / CHUNK_SIZE), floor((float) block_z / CHUNK_SIZE));
+    if (chunk == nullptr) {
+        // Without a chunk to start from, nothing is known to be occluded.
+        for (auto chunk: self->chunks_) {
+            for (int s = 0; s < SECTION_COUNT; s++) {
+                chunk->enterSection(s, -1);
+            }
+        }
+        return;
+    }
+
+    voxel::ArrayList<SectionVisit> &queue = self->visibility_queue_;
+    queue.clear();
+    chunk->enterSection(section, -1);
+    queue.append({chunk, (int8_t) section, -1, 0});
+    for (unsigned int head = 0; head < queue.size(); head++) {
+        SectionVisit visit = queue[head];
+        for (int to = 0; to < FACE_COUNT; to++) {
+            if (visit.directions & (1 << (to ^ 1))) continue;
+            if (visit.face >= 0 && !visit.chunk->sectionConnects(visit.section, visit.face, to)) continue;
+
+            int next_section = visit.section + face_directions[to][1];
+            if (next_section < 0 || next_section >= SECTION_COUNT) continue;
+            Chunk *next = visit.chunk;
+            if (face_directions[to][0] != 0 || face_directions[to][2] != 0) {
+                next = world_get_chunk(self, next->x() + face_directions[to][0], next->z() + face_directions[to][2]);
+                if (next == nullptr || !world_chunk_in_range(self, next)) continue;
+            }
+
+            aabb3_t bounds = next->sectionBounds(next_section);
+            if (!frustum_intersects_aabb(&self->frustum, &bounds)) continue;
+            if (!next->enterSection(next_section, to ^ 1)) continue;
+            queue.append({next, (int8_t) next_section, (int8_t) (to ^ 1), (uint8_t) (visit.directions | 1 << to)});
+        }
+    }
+}
+
 /**
  * This function is called once per frame. 
  * The timing of this function is dependent on the default framerate of 
@@ -475,36 +905,52 @@ void world_message_handler(World *self, void *message) {
  * computational demands of the game.
  * 
  * This function should perform drawing operations only!
- * Physics operations should all be performed in the `world_update` function.
+ * Physics operations should all be performed in the `world_update` function,
+ * which `world_advance` runs in fixed steps independent of the framerate.
  */
 void on_animation_frame(World *world, float dt, float aspect) {
     
+    // Bodies are drawn between their last two simulated positions, by the
+    // fraction of a physics step which world_advance left unsimulated.
+    dyn_aabb3_interpolate(&world->player.physics_object, world->interpolation, &world->camera_position);
     world_get_projection_matrix(world, aspect);
 
 
     // Draw all mobs
     for (auto mob: world->mobs_) {
-        mob->draw(&world->projection_matrix);
+        mob->draw(&world->projection_matrix, world->interpolation);
     }
 
     // Draw all items
     for (auto item: world->items){
-        item->draw(&world->projection_matrix);
+        item->draw(&world->projection_matrix, world->interpolation);
     }
     
-      // Draw all chunks within a VISIBLE_CHUNK_RADIUS distance measured in
-    // taxicab coordinates. 
-    auto pchunk = world->player.chunk();
+    // Draw all chunks within a VISIBLE_CHUNK_RADIUS distance measured in
+    // taxicab coordinates, skipping sections which lie outside the view
+    // frustum or are hidden from the camera by opaque blocks. Chunks outside
+    // the frustum are not updated: their meshes are rebuilt once they come
+    // into view, and the occlusion search never enters them.
+    world->cull_stats = cull_stats_t{};
+    frustum_init(&world->frustum, &world->projection_matrix);
     for (auto &chunk: world->chunks_) {
-        if (abs(chunk->x() - pchunk[0]) + abs(chunk->z() - pchunk[1]) <= VISIBLE_CHUNK_RADIUS) {
+        chunk->clearReachable();
+        aabb3_t bounds = chunk->bounds();
+        if (world_chunk_in_range(world, chunk) && frustum_intersects_aabb(&world->frustum, &bounds)) {
             chunk->update();
+        }
+    }
+    world_find_reachable_sections(world);
+
+    for (auto &chunk: world->chunks_) {
+        if (world_chunk_in_range(world, chunk)) {
+            chunk->cull(&world->frustum, &world->cull_stats);
             chunk->draw_opaque(&world->projection_matrix);
         }
     }
-    
 
     for (auto &chunk: world->chunks_) {
-        if (abs(chunk->x() - pchunk[0]) + abs(chunk->z() - pchunk[1]) <= VISIBLE_CHUNK_RADIUS) {
+        if (world_chunk_in_range(world, chunk)) {
             chunk->draw_transparent(&world->projection_matrix);
         }
     }